@@ -3,6 +3,7 @@ SUBDIRS += src plugin tools tests doc
 
 plugin.depends = src
 tools.depends = src
+tests.depends = src
 
 QMAKE_CLEAN += \
     build-stamp \
@@ -0,0 +1,253 @@
+// This file is part of lipstick, a QML desktop library
+//
+// Copyright (c) 2013 Jolla Ltd.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation
+// and appearing in the file LICENSE.LGPL included in the packaging
+// of this file.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QLocale>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <mdesktopentry.h>
+
+#include "launcheritem.h"
+#include "desktopentrycache.h"
+
+// The file starts with the magic, the version, the locale and an index of
+// (path, size, modification time, offset) records. The entries follow the
+// index; their offsets are relative to the end of it.
+static const quint32 CACHE_MAGIC = 0x4c444543;
+static const quint32 CACHE_VERSION = 1;
+
+static QDataStream &operator<<(QDataStream &stream, const DesktopEntryData &data)
+{
+    return stream << data.fileName << data.exec << data.name << data.nameUnlocalized
+                  << data.type << data.icon << data.categories << data.noDisplay << data.isValid;
+}
+
+static QDataStream &operator>>(QDataStream &stream, DesktopEntryData &data)
+{
+    return stream >> data.fileName >> data.exec >> data.name >> data.nameUnlocalized
+                  >> data.type >> data.icon >> data.categories >> data.noDisplay >> data.isValid;
+}
+
+static QString cacheFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/lipstick/desktop-entries.cache";
+}
+
+DesktopEntryData::DesktopEntryData(MDesktopEntry &entry)
+    : fileName(entry.fileName())
+    , exec(entry.exec())
+    , name(entry.name())
+    , nameUnlocalized(entry.nameUnlocalized())
+    , type(entry.type())
+    , icon(entry.icon())
+    , categories(entry.categories())
+    , noDisplay(entry.noDisplay())
+    , isValid(entry.isValid())
+{
+}
+
+DesktopEntryCache *DesktopEntryCache::instance()
+{
+    static DesktopEntryCache cache;
+    return &cache;
+}
+
+DesktopEntryCache::DesktopEntryCache()
+    : m_locale(QLocale::system().name())
+    , m_file(cacheFileName())
+    , m_map(0)
+    , m_mapSize(0)
+    , m_dataStart(0)
+    , m_dirty(false)
+{
+    load();
+}
+
+DesktopEntryCache::~DesktopEntryCache()
+{
+}
+
+void DesktopEntryCache::load()
+{
+    if (!m_file.open(QIODevice::ReadOnly))
+        return;
+
+    m_mapSize = m_file.size();
+    m_map = m_file.map(0, m_mapSize);
+    if (!m_map) {
+        m_file.close();
+        return;
+    }
+
+    QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(m_map), m_mapSize);
+    QDataStream stream(bytes);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString locale;
+    quint32 count = 0;
+    stream >> magic >> version >> locale >> count;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION || locale != m_locale || stream.status() != QDataStream::Ok) {
+        LAUNCHER_DEBUG("Discarding desktop entry cache made for locale" << locale);
+        m_file.unmap(m_map);
+        m_file.close();
+        m_map = 0;
+        return;
+    }
+
+    for (quint32 ii = 0; ii < count && stream.status() == QDataStream::Ok; ++ii) {
+        QString path;
+        Record record;
+        stream >> path >> record.size >> record.modified >> record.offset;
+        m_records.insert(path, record);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Desktop entry cache" << m_file.fileName() << "is corrupt";
+        m_records.clear();
+        m_file.unmap(m_map);
+        m_file.close();
+        m_map = 0;
+        return;
+    }
+
+    m_dataStart = stream.device()->pos();
+}
+
+QSharedPointer<DesktopEntryData> DesktopEntryCache::decode(qint64 offset) const
+{
+    if (!m_map || offset < 0 || m_dataStart + offset >= m_mapSize)
+        return QSharedPointer<DesktopEntryData>();
+
+    QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(m_map + m_dataStart + offset),
+                                               m_mapSize - m_dataStart - offset);
+    QDataStream stream(bytes);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    QSharedPointer<DesktopEntryData> data(new DesktopEntryData);
+    stream >> *data;
+    if (stream.status() != QDataStream::Ok)
+        return QSharedPointer<DesktopEntryData>();
+
+    return data;
+}
+
+QSharedPointer<DesktopEntryData> DesktopEntryCache::entry(const QString &path)
+{
+    QFileInfo info(path);
+    if (!info.exists()) {
+        MDesktopEntry desktopEntry(path);
+        return QSharedPointer<DesktopEntryData>(new DesktopEntryData(desktopEntry));
+    }
+
+    qint64 size = info.size();
+    qint64 modified = info.lastModified().toMSecsSinceEpoch();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        QHash<QString, Record>::iterator it = m_records.find(path);
+        if (it != m_records.end() && it->size == size && it->modified == modified) {
+            if (!it->data)
+                it->data = decode(it->offset);
+            if (it->data) {
+                it->used = true;
+                return it->data;
+            }
+        }
+    }
+
+    // Parse without holding the lock, other threads may be doing the same
+    LAUNCHER_DEBUG("Parsing desktop entry" << path);
+    MDesktopEntry desktopEntry(path);
+
+    QMutexLocker locker(&m_mutex);
+    Record record;
+    record.size = size;
+    record.modified = modified;
+    record.used = true;
+    record.data = QSharedPointer<DesktopEntryData>(new DesktopEntryData(desktopEntry));
+    m_records.insert(path, record);
+    m_dirty = true;
+
+    return record.data;
+}
+
+void DesktopEntryCache::invalidate(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_records.remove(path))
+        m_dirty = true;
+}
+
+void DesktopEntryCache::save()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dirty)
+        return;
+
+    // Entries of desktop files that were not seen during this session
+    // belong to files removed while lipstick was not running
+    QByteArray entries;
+    QDataStream entryStream(&entries, QIODevice::WriteOnly);
+    entryStream.setVersion(QDataStream::Qt_5_0);
+    QList<QPair<QString, Record> > index;
+    for (QHash<QString, Record>::iterator it = m_records.begin(); it != m_records.end();) {
+        if (it->used && !it->data)
+            it->data = decode(it->offset);
+        if (!it->used || !it->data) {
+            it = m_records.erase(it);
+            continue;
+        }
+
+        it->offset = entries.size();
+        entryStream << *it->data;
+        index.append(qMakePair(it.key(), *it));
+        ++it;
+    }
+
+    QDir().mkpath(QFileInfo(m_file.fileName()).absolutePath());
+    QSaveFile file(m_file.fileName());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot write desktop entry cache" << file.fileName() << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << CACHE_MAGIC << CACHE_VERSION << m_locale << quint32(index.count());
+    for (int ii = 0; ii < index.count(); ++ii) {
+        const Record &record = index.at(ii).second;
+        stream << index.at(ii).first << record.size << record.modified << record.offset;
+    }
+    stream.writeRawData(entries.constData(), entries.size());
+
+    if (!file.commit()) {
+        qWarning() << "Cannot write desktop entry cache" << file.fileName() << file.errorString();
+        return;
+    }
+
+    // Everything is decoded now, so the old mapping is not needed anymore
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_file.close();
+        m_map = 0;
+    }
+    m_dirty = false;
+}
@@ -0,0 +1,91 @@
+// This file is part of lipstick, a QML desktop library
+//
+// Copyright (c) 2013 Jolla Ltd.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation
+// and appearing in the file LICENSE.LGPL included in the packaging
+// of this file.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+
+#ifndef DESKTOPENTRYCACHE_H
+#define DESKTOPENTRYCACHE_H
+
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QStringList>
+
+class MDesktopEntry;
+
+//! The fields of a desktop entry used by the launcher
+struct DesktopEntryData
+{
+    DesktopEntryData() : noDisplay(false), isValid(false) {}
+    explicit DesktopEntryData(MDesktopEntry &entry);
+
+    QString fileName;
+    QString exec;
+    QString name;
+    QString nameUnlocalized;
+    QString type;
+    QString icon;
+    QStringList categories;
+    bool noDisplay;
+    bool isValid;
+};
+
+/*!
+ * Keeps the parsed desktop entries across restarts in a binary file, so
+ * that the launcher can be populated without parsing every desktop file.
+ * An entry is only used while the size and modification time of its file
+ * and the system locale are those it was parsed with. The file is mapped
+ * at startup and the entries are decoded as they are looked up; changes
+ * are written back with save(). The cache can be used from any thread.
+ */
+class DesktopEntryCache
+{
+public:
+    static DesktopEntryCache *instance();
+
+    //! Returns the entry for the desktop file, parsing the file if there is no valid cached one
+    QSharedPointer<DesktopEntryData> entry(const QString &path);
+    //! Drops the cached entry, for files the launcher monitor reported changed or removed
+    void invalidate(const QString &path);
+    void save();
+
+private:
+    struct Record
+    {
+        Record() : size(-1), modified(0), offset(-1), used(false) {}
+
+        qint64 size;
+        qint64 modified;
+        qint64 offset;
+        bool used;
+        QSharedPointer<DesktopEntryData> data;
+    };
+
+    DesktopEntryCache();
+    ~DesktopEntryCache();
+
+    void load();
+    QSharedPointer<DesktopEntryData> decode(qint64 offset) const;
+
+    QString m_locale;
+    QFile m_file;
+    uchar *m_map;
+    qint64 m_mapSize;
+    qint64 m_dataStart;
+    QHash<QString, Record> m_records;
+    mutable QMutex m_mutex;
+    bool m_dirty;
+};
+
+#endif // DESKTOPENTRYCACHE_H
@@ -20,14 +20,15 @@
 #include <QFile>
 #include <QDir>
 #include <QSettings>
-#include <QTimer>
 #include <mdesktopentry.h>
 
 #ifdef HAVE_CONTENTACTION
 #include <contentaction.h>
 #endif
 
+#include "desktopentrycache.h"
 #include "launcheritem.h"
+#include "launchtracker.h"
 
 LauncherItem::LauncherItem(const QString &filePath, QObject *parent)
     : QObject(parent)
@@ -38,9 +39,6 @@ LauncherItem::LauncherItem(const QString &filePath, QObject *parent)
     if (!filePath.isEmpty()) {
         setFilePath(filePath);
     }
-
-    // TODO: match the PID of the window thumbnails with the launcher processes
-    // Launching animation will be disabled if the window of the launched app shows up
 }
 
 LauncherItem::~LauncherItem()
@@ -50,7 +48,7 @@ LauncherItem::~LauncherItem()
 void LauncherItem::setFilePath(const QString &filePath)
 {
     if (!filePath.isEmpty()) {
-        _desktopEntry = QSharedPointer<MDesktopEntry>(new MDesktopEntry(filePath));
+        _desktopEntry = DesktopEntryCache::instance()->entry(filePath);
     } else {
         _desktopEntry.clear();
     }
@@ -58,24 +56,31 @@ void LauncherItem::setFilePath(const QString &filePath)
     emit this->itemChanged();
 }
 
+void LauncherItem::setDesktopEntry(const QSharedPointer<DesktopEntryData> &desktopEntry)
+{
+    _desktopEntry = desktopEntry;
+
+    emit this->itemChanged();
+}
+
 QString LauncherItem::filePath() const
 {
-    return !_desktopEntry.isNull() ? _desktopEntry->fileName() : QString();
+    return !_desktopEntry.isNull() ? _desktopEntry->fileName : QString();
 }
 
 QString LauncherItem::exec() const
 {
-    return !_desktopEntry.isNull() ? _desktopEntry->exec() : QString();
+    return !_desktopEntry.isNull() ? _desktopEntry->exec : QString();
 }
 
 QString LauncherItem::title() const
 {
-    return !_desktopEntry.isNull() ? _desktopEntry->name() : QString();
+    return !_desktopEntry.isNull() ? _desktopEntry->name : QString();
 }
 
 QString LauncherItem::entryType() const
 {
-    return !_desktopEntry.isNull() ? _desktopEntry->type() : QString();
+    return !_desktopEntry.isNull() ? _desktopEntry->type : QString();
 }
 
 QString LauncherItem::iconId() const
@@ -89,22 +94,22 @@ QString LauncherItem::iconId() const
 
 QStringList LauncherItem::desktopCategories() const
 {
-    return !_desktopEntry.isNull() ? _desktopEntry->categories() : QStringList();
+    return !_desktopEntry.isNull() ? _desktopEntry->categories : QStringList();
 }
 
 QString LauncherItem::titleUnlocalized() const
 {
-    return !_desktopEntry.isNull() ? _desktopEntry->nameUnlocalized() : QString();
+    return !_desktopEntry.isNull() ? _desktopEntry->nameUnlocalized : QString();
 }
 
 bool LauncherItem::shouldDisplay() const
 {
-    return !_desktopEntry.isNull() ? !_desktopEntry->noDisplay() : false;
+    return !_desktopEntry.isNull() ? !_desktopEntry->noDisplay : false;
 }
 
 bool LauncherItem::isValid() const
 {
-    return !_desktopEntry.isNull() ? _desktopEntry->isValid() : false;
+    return !_desktopEntry.isNull() ? _desktopEntry->isValid : false;
 }
 
 bool LauncherItem::isLaunching() const
@@ -126,23 +131,24 @@ void LauncherItem::launchApplication()
         return;
 
 #if defined(HAVE_CONTENTACTION)
-    LAUNCHER_DEBUG("launching content action for" << _desktopEntry->name());
-    ContentAction::Action action = ContentAction::Action::launcherAction(_desktopEntry, QStringList());
+    LAUNCHER_DEBUG("launching content action for" << _desktopEntry->name);
+    QSharedPointer<MDesktopEntry> desktopEntry(new MDesktopEntry(filePath()));
+    ContentAction::Action action = ContentAction::Action::launcherAction(desktopEntry, QStringList());
     action.trigger();
 #else
-    LAUNCHER_DEBUG("launching exec line for" << _desktopEntry->name());
+    LAUNCHER_DEBUG("launching exec line for" << _desktopEntry->name);
 
     // Get the command text from the desktop entry
-    QString commandText = _desktopEntry->exec();
+    QString commandText = _desktopEntry->exec;
 
     // Take care of the freedesktop standards things
 
     commandText.replace(QRegExp("%k"), filePath());
-    commandText.replace(QRegExp("%c"), _desktopEntry->name());
+    commandText.replace(QRegExp("%c"), _desktopEntry->name);
     commandText.remove(QRegExp("%[fFuU]"));
 
-    if (!_desktopEntry->icon().isEmpty())
-        commandText.replace(QRegExp("%i"), QString("--icon ") + _desktopEntry->icon());
+    if (!_desktopEntry->icon.isEmpty())
+        commandText.replace(QRegExp("%i"), QString("--icon ") + _desktopEntry->icon);
 
     // DETAILS: http://standards.freedesktop.org/desktop-entry-spec/latest/index.html
     // DETAILS: http://standards.freedesktop.org/desktop-entry-spec/latest/ar01s06.html
@@ -153,20 +159,21 @@ void LauncherItem::launchApplication()
 
     setIsLaunching(true);
 
-    // This is a failsafe to allow launching again after 5 seconds in case the application crashes on startup and no window is ever created
-    QTimer::singleShot(5000, this, SLOT(setIsLaunching()));
+    // Launching ends when the window of the application shows up
+    LaunchTracker::instance()->trackLaunch(this);
 }
 
 bool LauncherItem::isStillValid()
 {
     // Force a reload of _desktopEntry
+    DesktopEntryCache::instance()->invalidate(filePath());
     setFilePath(filePath());
     return isValid();
 }
 
 QString LauncherItem::getOriginalIconId() const
 {
-    return !_desktopEntry.isNull() ? _desktopEntry->icon() : QString();
+    return !_desktopEntry.isNull() ? _desktopEntry->icon : QString();
 }
 
 void LauncherItem::setIconFilename(const QString &path)
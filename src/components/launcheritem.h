@@ -33,6 +33,7 @@
 #include "lipstickglobal.h"
 
 class MDesktopEntry;
+struct DesktopEntryData;
 
 class LIPSTICK_EXPORT LauncherItem : public QObject
 {
@@ -50,7 +51,7 @@ class LIPSTICK_EXPORT LauncherItem : public QObject
     Q_PROPERTY(bool isValid READ isValid NOTIFY itemChanged)
     Q_PROPERTY(bool isLaunching READ isLaunching WRITE setIsLaunching NOTIFY isLaunchingChanged)
 
-    QSharedPointer<MDesktopEntry> _desktopEntry;
+    QSharedPointer<DesktopEntryData> _desktopEntry;
     bool _isLaunching;
     QString _customIconFilename;
     int _serial;
@@ -81,6 +82,10 @@ public:
 
     Q_INVOKABLE void launchApplication();
 
+private:
+    friend class LauncherModel;
+    void setDesktopEntry(const QSharedPointer<DesktopEntryData> &desktopEntry);
+
 signals:
     void itemChanged();
     void isLaunchingChanged();
@@ -19,7 +19,9 @@
 #include <QDebug>
 #include <QFile>
 #include <QSettings>
+#include <QRunnable>
 
+#include "desktopentrycache.h"
 #include "launchermodel.h"
 
 
@@ -28,6 +30,11 @@
 
 #define LAUNCHER_KEY_FOR_PATH(path) ("LauncherOrder/" + path)
 
+// Desktop entries are loaded in batches of this many files; the batches
+// holding the items of the first page are loaded ahead of the others
+#define LAUNCHER_LOAD_BATCH_SIZE 8
+#define LAUNCHER_FIRST_PAGE_SIZE 20
+
 static inline bool isDesktopFile(const QString &filename)
 {
     return filename.startsWith(LAUNCHER_APPS_PATH) && filename.endsWith(".desktop");
@@ -57,12 +64,51 @@ static inline QString filenameFromIconId(const QString &filename)
     return QString("%1%2%3").arg(LAUNCHER_ICONS_PATH).arg(filename).arg(".png");
 }
 
+class LauncherModel::DesktopEntryLoader : public QRunnable
+{
+public:
+    DesktopEntryLoader(LauncherModel *model, int batch, const QStringList &paths)
+        : m_model(model), m_batch(batch), m_paths(paths) {}
+
+    void run()
+    {
+        QList<LoadedEntry> entries;
+        foreach (const QString &path, m_paths) {
+            LoadedEntry loaded;
+            loaded.path = path;
+
+            QSharedPointer<DesktopEntryData> entry = DesktopEntryCache::instance()->entry(path);
+            if (entry->isValid && !entry->noDisplay) {
+                loaded.entry = entry;
+
+                // Try to look up an already-installed icon in the icons directory
+                QString iconname = filenameFromIconId(entry->icon);
+                if (QFile(iconname).exists())
+                    loaded.iconFile = iconname;
+            }
+
+            entries.append(loaded);
+        }
+
+        QMutexLocker locker(&m_model->_loadedMutex);
+        m_model->_loadedBatches.insert(m_batch, entries);
+        QMetaObject::invokeMethod(m_model, "applyLoadedBatches", Qt::QueuedConnection);
+    }
+
+private:
+    LauncherModel *m_model;
+    int m_batch;
+    QStringList m_paths;
+};
+
 LauncherModel::LauncherModel(QObject *parent) :
     QObjectListModel(parent),
     _fileSystemWatcher(),
     _launcherSettings("nemomobile", "lipstick"),
     _globalSettings("/usr/share/lipstick/lipstick.conf", QSettings::IniFormat),
-    _launcherMonitor(LAUNCHER_APPS_PATH, LAUNCHER_ICONS_PATH)
+    _launcherMonitor(LAUNCHER_APPS_PATH, LAUNCHER_ICONS_PATH),
+    _scheduledBatches(0),
+    _appliedBatches(0)
 {
     // Set up the monitor for icon and desktop file changes
     connect(&_launcherMonitor, SIGNAL(filesUpdated(const QStringList &, const QStringList &, const QStringList &)),
@@ -81,6 +127,9 @@ LauncherModel::LauncherModel(QObject *parent) :
 
 LauncherModel::~LauncherModel()
 {
+    // The loaders post their results to the model
+    _loaderPool.clear();
+    _loaderPool.waitForDone();
 }
 
 void LauncherModel::onFilesUpdated(const QStringList &added,
@@ -92,9 +141,12 @@ void LauncherModel::onFilesUpdated(const QStringList &added,
     foreach (const QString &filename, removed) {
         if (isDesktopFile(filename)) {
             // Desktop file has been removed - remove launcher
+            DesktopEntryCache::instance()->invalidate(filename);
+            _pendingPaths.remove(filename);
             LauncherItem *item = itemInModel(filename);
             if (item != NULL) {
                 LAUNCHER_DEBUG("Removing launcher item:" << filename);
+                forgetPendingItem(item);
                 removeItem(item);
             }
         } else if (isIconFile(filename)) {
@@ -103,21 +155,13 @@ void LauncherModel::onFilesUpdated(const QStringList &added,
         }
     }
 
+    QStringList load;
     foreach (const QString &filename, added) {
         if (isDesktopFile(filename)) {
             // New desktop file appeared - add launcher
-            if (itemInModel(filename) == NULL) {
+            if (itemInModel(filename) == NULL && !_pendingPaths.contains(filename)) {
                 LAUNCHER_DEBUG("Trying to add launcher item:" << filename);
-                LauncherItem *item = addItemIfValid(filename, itemsWithPositions);
-
-                if (item != NULL) {
-                    // Try to look up an already-installed icon in the icons directory
-                    QString iconname = filenameFromIconId(item->getOriginalIconId());
-                    if (QFile(iconname).exists()) {
-                        LAUNCHER_DEBUG("Loading existing icon:" << iconname);
-                        updateItemsWithIcon(iconname, true);
-                    }
-                }
+                load.append(filename);
             } else {
                 // This "should not" happen...
                 qWarning() << "New file already in model:" << filename;
@@ -137,6 +181,7 @@ void LauncherModel::onFilesUpdated(const QStringList &added,
                 if (!isValid) {
                     // File has changed in such a way (e.g. Hidden=true) that
                     // it now should become invisible again
+                    forgetPendingItem(item);
                     removeItem(item);
                 } else {
                     // File has been updated and is still valid; check if we
@@ -152,8 +197,10 @@ void LauncherModel::onFilesUpdated(const QStringList &added,
                     }
                 }
             } else {
-                // No item yet (maybe it had Hidden=true before), try to see if
-                // we should show the item now
+                // No item yet (maybe it had Hidden=true before, or it is
+                // still being loaded), try to see if we should show the item now
+                DesktopEntryCache::instance()->invalidate(filename);
+                _pendingPaths.remove(filename);
                 addItemIfValid(filename, itemsWithPositions);
             }
         } else if (isIconFile(filename)) {
@@ -163,7 +210,104 @@ void LauncherModel::onFilesUpdated(const QStringList &added,
     }
 
     reorderItems(itemsWithPositions);
-    savePositions();
+    loadDesktopEntries(load);
+
+    if (_pendingPaths.isEmpty()) {
+        savePositions();
+
+        // Keep what was parsed for the next start
+        DesktopEntryCache::instance()->save();
+    }
+}
+
+void LauncherModel::loadDesktopEntries(const QStringList &paths)
+{
+    if (paths.isEmpty())
+        return;
+
+    // Entries with a position are queued in the order of their position, so
+    // that the first page is filled before the rest is loaded
+    QMap<int, QString> placed;
+    QStringList unplaced;
+    foreach (const QString &path, paths) {
+        QVariant pos = launcherPos(path);
+        if (pos.isValid())
+            placed.insertMulti(pos.toInt(), path);
+        else
+            unplaced.append(path);
+    }
+
+    QStringList ordered = placed.values() + unplaced;
+    for (int ii = 0; ii < ordered.count(); ii += LAUNCHER_LOAD_BATCH_SIZE) {
+        QStringList batch = ordered.mid(ii, LAUNCHER_LOAD_BATCH_SIZE);
+        foreach (const QString &path, batch)
+            _pendingPaths.insert(path, _scheduledBatches);
+
+        int priority = ii < LAUNCHER_FIRST_PAGE_SIZE ? 1 : 0;
+        _loaderPool.start(new DesktopEntryLoader(this, _scheduledBatches++, batch), priority);
+    }
+}
+
+void LauncherModel::applyLoadedBatches()
+{
+    // Batches are added in the order they were queued in, whichever
+    // finished loading first
+    QMap<int, QList<LoadedEntry> > batches;
+    {
+        QMutexLocker locker(&_loadedMutex);
+        for (; _loadedBatches.contains(_appliedBatches); ++_appliedBatches)
+            batches.insert(_appliedBatches, _loadedBatches.take(_appliedBatches));
+    }
+
+    if (batches.isEmpty())
+        return;
+
+    for (QMap<int, QList<LoadedEntry> >::const_iterator batch = batches.constBegin(); batch != batches.constEnd(); ++batch) {
+        foreach (const LoadedEntry &loaded, batch.value()) {
+            // Removed, or queued again in a later batch, while it was being loaded
+            QHash<QString, int>::iterator pending = _pendingPaths.find(loaded.path);
+            if (pending == _pendingPaths.end() || pending.value() != batch.key())
+                continue;
+            _pendingPaths.erase(pending);
+
+            if (!loaded.entry) {
+                LAUNCHER_DEBUG("Item" << loaded.path << "is not valid or should not be displayed");
+                continue;
+            }
+
+            LauncherItem *item = new LauncherItem(QString(), this);
+            item->setDesktopEntry(loaded.entry);
+            addItem(item);
+
+            if (!loaded.iconFile.isEmpty()) {
+                LAUNCHER_DEBUG("Loading existing icon:" << loaded.iconFile);
+                item->setIconFilename(loaded.iconFile);
+            }
+
+            QVariant pos = launcherPos(loaded.path);
+            if (pos.isValid())
+                _pendingPositions.insert(pos.toInt(), item);
+        }
+    }
+
+    // Positions beyond the items loaded so far are applied by a later batch
+    reorderItems(_pendingPositions);
+
+    if (_pendingPaths.isEmpty()) {
+        _pendingPositions.clear();
+        savePositions();
+        DesktopEntryCache::instance()->save();
+    }
+}
+
+void LauncherModel::forgetPendingItem(LauncherItem *item)
+{
+    for (QMap<int, LauncherItem *>::iterator it = _pendingPositions.begin(); it != _pendingPositions.end();) {
+        if (it.value() == item)
+            it = _pendingPositions.erase(it);
+        else
+            ++it;
+    }
 }
 
 void LauncherModel::updateItemsWithIcon(const QString &filename, bool existing)
@@ -262,6 +406,10 @@ void LauncherModel::setDirectories(QStringList newDirectories)
 
 void LauncherModel::savePositions()
 {
+    // Saving now would drop the positions of the items still being loaded
+    if (!_pendingPaths.isEmpty())
+        return;
+
     _fileSystemWatcher.removePath(_launcherSettings.fileName());
     _launcherSettings.clear();
     QList<LauncherItem *> *currentLauncherList = getList<LauncherItem>();
@@ -20,6 +20,9 @@
 #include <QObject>
 #include <QSettings>
 #include <QFileSystemWatcher>
+#include <QMutex>
+#include <QHash>
+#include <QThreadPool>
 
 #include "launcheritem.h"
 #include "qobjectlistmodel.h"
@@ -39,9 +42,27 @@ class LIPSTICK_EXPORT LauncherModel : public QObjectListModel
     QSettings _globalSettings;
     LauncherMonitor _launcherMonitor;
 
+    struct LoadedEntry
+    {
+        QString path;
+        QSharedPointer<DesktopEntryData> entry;
+        QString iconFile;
+    };
+    class DesktopEntryLoader;
+
+    QThreadPool _loaderPool;
+    // Batch each path is being loaded in; results of earlier loads are stale
+    QHash<QString, int> _pendingPaths;
+    QMap<int, LauncherItem *> _pendingPositions;
+    int _scheduledBatches;
+    int _appliedBatches;
+    QMutex _loadedMutex;
+    QMap<int, QList<LoadedEntry> > _loadedBatches;
+
 private slots:
     void monitoredFileChanged(const QString &changedPath);
     void onFilesUpdated(const QStringList &added, const QStringList &modified, const QStringList &removed);
+    void applyLoadedBatches();
 
 public:
     explicit LauncherModel(QObject *parent = 0);
@@ -62,6 +83,8 @@ private:
     LauncherItem *itemInModel(const QString &path);
     QVariant launcherPos(const QString &path);
     LauncherItem *addItemIfValid(const QString &path, QMap<int, LauncherItem *> &itemsWithPositions);
+    void loadDesktopEntries(const QStringList &paths);
+    void forgetPendingItem(LauncherItem *item);
     void updateItemsWithIcon(const QString &filename, bool existing);
 };
 
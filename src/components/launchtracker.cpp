@@ -0,0 +1,208 @@
+// This file is part of lipstick, a QML desktop library
+//
+// Copyright (c) 2013 Jolla Ltd.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation
+// and appearing in the file LICENSE.LGPL included in the packaging
+// of this file.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QTimer>
+#include "homeapplication.h"
+#include "lipstickcompositor.h"
+#include "lipstickcompositorwindow.h"
+#include "launcheritem.h"
+#include "launchtracker.h"
+
+// Failsafe to allow launching again in case the application crashes on
+// startup and no window is ever shown
+static const int LAUNCH_TIMEOUT = 5000;
+
+LaunchTracker *LaunchTracker::instance_ = 0;
+
+LaunchTracker *LaunchTracker::instance()
+{
+    if (instance_ == 0) {
+        instance_ = new LaunchTracker(qApp);
+    }
+    return instance_;
+}
+
+LaunchTracker::LaunchTracker(QObject *parent) :
+    QObject(parent),
+    m_frameTracking(false)
+{
+}
+
+void LaunchTracker::trackLaunch(LauncherItem *item)
+{
+    for (int ii = m_launches.count() - 1; ii >= 0; --ii) {
+        if (m_launches.at(ii).item == item)
+            m_launches.removeAt(ii);
+    }
+    updateFrameTracking();
+
+    Launch launch;
+    launch.item = item;
+    launch.desktopFileId = QFileInfo(item->filePath()).fileName();
+
+    // The compositor knows windows by the application their process runs;
+    // find it the same way in the Exec line, without its field codes
+    QStringList arguments;
+    foreach (const QString &argument, item->exec().split(QRegExp("\\s+"), QString::SkipEmptyParts)) {
+        if (!argument.startsWith(QLatin1Char('%')))
+            arguments.append(argument);
+    }
+    QString application = LipstickCompositor::commandApplication(arguments);
+    launch.applicationId = application.isEmpty() ? launch.desktopFileId : application + QLatin1String(".desktop");
+
+    launch.clock.start();
+    launch.windowId = 0;
+    launch.firstFrame = 0;
+
+    connectCompositor();
+    QList<int> ids = windowIds(launch);
+    launch.cold = ids.isEmpty();
+    m_launches.append(launch);
+
+    if (!launch.cold && m_compositor && ids.contains(m_compositor->topmostWindowId()))
+        finishLaunch(m_launches.count() - 1, false);
+    else
+        QTimer::singleShot(LAUNCH_TIMEOUT, this, SLOT(expireLaunches()));
+}
+
+void LaunchTracker::connectCompositor()
+{
+    LipstickCompositor *c = LipstickCompositor::instance();
+    if (!c || c == m_compositor)
+        return;
+
+    m_compositor = c;
+    m_frameTracking = false;
+    connect(c, SIGNAL(windowAdded(QObject*)), this, SLOT(windowAdded(QObject*)));
+    connect(c, SIGNAL(topmostWindowIdChanged()), this, SLOT(topmostWindowIdChanged()));
+}
+
+void LaunchTracker::updateFrameTracking()
+{
+    bool waiting = false;
+    foreach (const Launch &launch, m_launches) {
+        if (launch.windowId) {
+            waiting = true;
+            break;
+        }
+    }
+
+    if (!m_compositor || waiting == m_frameTracking)
+        return;
+
+    // The render thread signals come with every frame; only listen to them
+    // while a window is waiting to be shown for the first time
+    m_frameTracking = waiting;
+    if (waiting) {
+        // A frame synchronized while not connected is not counted when it
+        // is swapped either, see frameSwappedOnRenderThread()
+        m_swappedFrames.store(m_synchronizedFrames.load());
+        connect(m_compositor, SIGNAL(afterSynchronizing()), this, SLOT(frameSynchronizedOnRenderThread()), Qt::DirectConnection);
+        connect(m_compositor, SIGNAL(frameSwapped()), this, SLOT(frameSwappedOnRenderThread()), Qt::DirectConnection);
+    } else {
+        disconnect(m_compositor, SIGNAL(afterSynchronizing()), this, SLOT(frameSynchronizedOnRenderThread()));
+        disconnect(m_compositor, SIGNAL(frameSwapped()), this, SLOT(frameSwappedOnRenderThread()));
+    }
+}
+
+QList<int> LaunchTracker::windowIds(const Launch &launch) const
+{
+    if (!m_compositor)
+        return QList<int>();
+
+    QList<int> ids = m_compositor->windowIdsForDesktopFile(launch.desktopFileId);
+    if (launch.applicationId != launch.desktopFileId)
+        ids += m_compositor->windowIdsForDesktopFile(launch.applicationId);
+    return ids;
+}
+
+void LaunchTracker::windowAdded(QObject *window)
+{
+    LipstickCompositorWindow *w = qobject_cast<LipstickCompositorWindow *>(window);
+    if (!w)
+        return;
+
+    for (int ii = 0; ii < m_launches.count(); ++ii) {
+        Launch &launch = m_launches[ii];
+        if (launch.cold && !launch.windowId && windowIds(launch).contains(w->windowId())) {
+            // The window is in the scene from the next synchronized frame on;
+            // frames already synchronized do not show it yet
+            launch.windowId = w->windowId();
+            launch.firstFrame = m_synchronizedFrames.load() + 1;
+        }
+    }
+    updateFrameTracking();
+}
+
+void LaunchTracker::topmostWindowIdChanged()
+{
+    int topmost = m_compositor->topmostWindowId();
+    for (int ii = m_launches.count() - 1; ii >= 0; --ii) {
+        const Launch &launch = m_launches.at(ii);
+        if (!launch.cold && windowIds(launch).contains(topmost))
+            finishLaunch(ii, false);
+    }
+}
+
+void LaunchTracker::frameSynchronizedOnRenderThread()
+{
+    // Called from render thread while the GUI thread is blocked
+    m_synchronizedFrames.fetchAndAddOrdered(1);
+}
+
+void LaunchTracker::frameSwappedOnRenderThread()
+{
+    // Called from render thread. A frame synchronized before the frames
+    // were tracked is not counted when it is swapped either.
+    if (m_swappedFrames.load() < m_synchronizedFrames.load())
+        m_swappedFrames.fetchAndAddOrdered(1);
+    QMetaObject::invokeMethod(this, "checkFirstFrames", Qt::QueuedConnection);
+}
+
+void LaunchTracker::checkFirstFrames()
+{
+    int swapped = m_swappedFrames.load();
+    for (int ii = m_launches.count() - 1; ii >= 0; --ii) {
+        const Launch &launch = m_launches.at(ii);
+        if (launch.windowId && swapped >= launch.firstFrame)
+            finishLaunch(ii, true);
+    }
+}
+
+void LaunchTracker::expireLaunches()
+{
+    for (int ii = m_launches.count() - 1; ii >= 0; --ii) {
+        Launch launch = m_launches.at(ii);
+        if (launch.clock.elapsed() < LAUNCH_TIMEOUT)
+            continue;
+
+        m_launches.removeAt(ii);
+        if (launch.item)
+            launch.item->setIsLaunching(false);
+    }
+    updateFrameTracking();
+}
+
+void LaunchTracker::finishLaunch(int index, bool cold)
+{
+    Launch launch = m_launches.takeAt(index);
+    updateFrameTracking();
+    if (launch.item)
+        launch.item->setIsLaunching(false);
+
+    emit HomeApplication::instance()->applicationLaunched(launch.desktopFileId, cold, launch.clock.elapsed());
+}
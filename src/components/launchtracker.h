@@ -0,0 +1,82 @@
+// This file is part of lipstick, a QML desktop library
+//
+// Copyright (c) 2013 Jolla Ltd.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License version 2.1 as published by the Free Software Foundation
+// and appearing in the file LICENSE.LGPL included in the packaging
+// of this file.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+
+#ifndef LAUNCHTRACKER_H
+#define LAUNCHTRACKER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+
+class LauncherItem;
+class LipstickCompositor;
+
+/*!
+ * Follows applications launched from launcher items until they are on
+ * screen. A cold launch ends with the first frame that shows the newly
+ * mapped window of the application, a warm launch when an already running
+ * window of it becomes the topmost window. The item's isLaunching flag is
+ * cleared at that point and the latency is published through
+ * HomeApplication::applicationLaunched(). Launches that do not show up
+ * within a few seconds are dropped.
+ */
+class LaunchTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    static LaunchTracker *instance();
+
+    void trackLaunch(LauncherItem *item);
+
+private slots:
+    void windowAdded(QObject *window);
+    void topmostWindowIdChanged();
+    void frameSynchronizedOnRenderThread();
+    void frameSwappedOnRenderThread();
+    void checkFirstFrames();
+    void expireLaunches();
+
+private:
+    struct Launch
+    {
+        QPointer<LauncherItem> item;
+        QString desktopFileId;
+        QString applicationId;
+        QElapsedTimer clock;
+        bool cold;
+        int windowId;
+        int firstFrame;
+    };
+
+    explicit LaunchTracker(QObject *parent = 0);
+
+    void connectCompositor();
+    void updateFrameTracking();
+    QList<int> windowIds(const Launch &launch) const;
+    void finishLaunch(int index, bool cold);
+
+    static LaunchTracker *instance_;
+
+    QList<Launch> m_launches;
+    QPointer<LipstickCompositor> m_compositor;
+    QAtomicInt m_synchronizedFrames;
+    QAtomicInt m_swappedFrames;
+    // Whether frames are counted, only while a cold launch waits for its first frame
+    bool m_frameTracking;
+};
+
+#endif // LAUNCHTRACKER_H
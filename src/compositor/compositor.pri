@@ -5,15 +5,19 @@ PUBLICHEADERS += \
     $$PWD/lipstickcompositorwindow.h \
     $$PWD/lipstickcompositorprocwindow.h \
     $$PWD/windowmodel.h \
+    $$PWD/framecapturebuffer.h \
 
 HEADERS += \
+    $$PWD/memorypressuremonitor.h \
     $$PWD/windowpixmapitem.h \
     $$PWD/windowproperty.h \
 
 SOURCES += \
+    $$PWD/framecapturebuffer.cpp \
     $$PWD/lipstickcompositor.cpp \
     $$PWD/lipstickcompositorwindow.cpp \
     $$PWD/lipstickcompositorprocwindow.cpp \
+    $$PWD/memorypressuremonitor.cpp \
     $$PWD/windowmodel.cpp \
     $$PWD/windowpixmapitem.cpp \
     $$PWD/windowproperty.cpp \
@@ -0,0 +1,322 @@
+/***************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd.
+**
+** This file is part of lipstick.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include <QImage>
+#include <QRunnable>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QDebug>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "framecapturebuffer.h"
+
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#endif
+
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT 0x0001
+#endif
+
+namespace {
+
+int createSharedMemory(size_t length)
+{
+    int fd = -1;
+    bool sealable = false;
+#ifdef SYS_memfd_create
+    fd = syscall(SYS_memfd_create, "lipstick-frame-capture", 0x1 /* MFD_CLOEXEC */ | 0x2 /* MFD_ALLOW_SEALING */);
+    sealable = fd >= 0;
+#endif
+    if (fd < 0) {
+        // Kernels without memfd; an unlinked POSIX shared memory object can't
+        // be sealed, but clients only ever get a read only descriptor, which
+        // can't be resized either
+        QByteArray name = "/lipstick-frame-capture-" + QByteArray::number(getpid());
+        fd = shm_open(name.constData(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd >= 0)
+            shm_unlink(name.constData());
+    }
+
+    if (fd >= 0 && ftruncate(fd, length) < 0) {
+        close(fd);
+        fd = -1;
+    }
+
+    // A client shrinking the file would crash the compositor with SIGBUS on the next frame
+    if (sealable && fd >= 0 && fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) {
+        close(fd);
+        fd = -1;
+    }
+
+    return fd;
+}
+
+int openReadOnly(int fd)
+{
+    // A new open file description, so clients can neither map it writable nor resize it
+    QByteArray path = "/proc/self/fd/" + QByteArray::number(fd);
+    return open(path.constData(), O_RDONLY | O_CLOEXEC);
+}
+
+quint64 monotonicTime()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return quint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+}
+
+class FrameCaptureScaler : public QRunnable
+{
+public:
+    FrameCaptureScaler(FrameCaptureBuffer *buffer, const QImage &image, quint64 timestamp)
+    : m_buffer(buffer), m_image(image), m_timestamp(timestamp)
+    {
+    }
+
+    void run()
+    {
+        // Scaling works channel by channel, so the RGBA bytes can be handled as ARGB32
+        m_buffer->writeFrame(m_image.scaled(m_buffer->m_size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation), m_timestamp);
+        m_buffer->m_scaling.storeRelease(0);
+    }
+
+private:
+    FrameCaptureBuffer *m_buffer;
+    QImage m_image;
+    quint64 m_timestamp;
+};
+
+FrameCaptureBuffer::FrameCaptureBuffer(const QSize &frameSize, qreal scale, qreal maxRate, int slotCount)
+: m_frameSize(frameSize), m_stride(0), m_fd(-1), m_readOnlyFd(-1), m_length(0), m_memory(0), m_minInterval(0), m_lastCapture(0),
+  m_readback(ReadbackUnknown), m_nextPixelBuffer(0), m_mapBufferRange(0), m_unmapBuffer(0)
+{
+    m_pixelBuffers[0] = m_pixelBuffers[1] = 0;
+    m_pixelBufferTimestamps[0] = m_pixelBufferTimestamps[1] = 0;
+
+    if (scale <= 0 || scale > 1)
+        scale = 1;
+    m_size = (QSizeF(frameSize) * scale).toSize().expandedTo(QSize(1, 1));
+    m_stride = m_size.width() * 4;
+
+    if (maxRate > 0)
+        m_minInterval = 1000000 / maxRate;
+
+    slotCount = qMax(2, slotCount);
+    size_t slotSize = (sizeof(FrameCaptureSlot) + size_t(m_stride) * m_size.height() + 7) & ~size_t(7);
+    m_length = sizeof(FrameCaptureHeader) + slotSize * slotCount;
+
+    m_fd = createSharedMemory(m_length);
+    if (m_fd < 0) {
+        qWarning() << "FrameCaptureBuffer: Could not create shared memory" << strerror(errno);
+        return;
+    }
+
+    m_readOnlyFd = openReadOnly(m_fd);
+    if (m_readOnlyFd < 0) {
+        qWarning() << "FrameCaptureBuffer: Could not open shared memory read only" << strerror(errno);
+        return;
+    }
+
+    void *memory = mmap(0, m_length, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (memory == MAP_FAILED) {
+        qWarning() << "FrameCaptureBuffer: Could not map shared memory" << strerror(errno);
+        return;
+    }
+    m_memory = static_cast<uchar *>(memory);
+
+    FrameCaptureHeader *header = reinterpret_cast<FrameCaptureHeader *>(m_memory);
+    header->magic = FrameCaptureHeader::Magic;
+    header->version = FrameCaptureHeader::Version;
+    header->slotCount = slotCount;
+    header->slotSize = slotSize;
+    header->width = m_size.width();
+    header->height = m_size.height();
+    header->stride = m_stride;
+    header->sequence = 0;
+
+    m_scaler.setMaxThreadCount(1);
+    m_clock.start();
+}
+
+FrameCaptureBuffer::~FrameCaptureBuffer()
+{
+    m_scaler.waitForDone();
+
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (m_readback == ReadbackPixelBuffers && context)
+        context->functions()->glDeleteBuffers(2, m_pixelBuffers);
+
+    if (m_memory)
+        munmap(m_memory, m_length);
+    if (m_fd >= 0)
+        close(m_fd);
+    if (m_readOnlyFd >= 0)
+        close(m_readOnlyFd);
+}
+
+void FrameCaptureBuffer::captureFrame()
+{
+    // Called from render thread
+    if (!m_memory)
+        return;
+
+    qint64 now = m_clock.nsecsElapsed() / 1000;
+    if (m_lastCapture && now - m_lastCapture < m_minInterval)
+        return;
+
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context)
+        return;
+
+    quint64 timestamp = monotonicTime();
+
+    if (m_readback == ReadbackUnknown)
+        m_readback = createPixelBuffers(context) ? ReadbackPixelBuffers : ReadbackSynchronous;
+
+    if (m_readback == ReadbackPixelBuffers) {
+        QOpenGLFunctions *functions = context->functions();
+        size_t length = size_t(m_frameSize.width()) * m_frameSize.height() * 4;
+
+        // Queue the readback of this frame; glReadPixels returns without
+        // waiting for the GPU when the target is a pixel pack buffer
+        functions->glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixelBuffers[m_nextPixelBuffer]);
+        functions->glReadPixels(0, 0, m_frameSize.width(), m_frameSize.height(), GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        m_pixelBufferTimestamps[m_nextPixelBuffer] = timestamp;
+
+        // The previous frame has had a whole frame to arrive
+        int previous = 1 - m_nextPixelBuffer;
+        if (m_pixelBufferTimestamps[previous]) {
+            functions->glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixelBuffers[previous]);
+            const uchar *pixels = static_cast<const uchar *>(m_mapBufferRange(GL_PIXEL_PACK_BUFFER, 0, length, GL_MAP_READ_BIT));
+            if (pixels) {
+                publishFrame(pixels, m_pixelBufferTimestamps[previous]);
+                m_unmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            m_pixelBufferTimestamps[previous] = 0;
+        }
+
+        functions->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        m_nextPixelBuffer = previous;
+    } else if (m_size == m_frameSize) {
+        // Read straight into the slot
+        quint64 sequence;
+        uchar *pixels = beginSlot(&sequence);
+        context->functions()->glReadPixels(0, 0, m_size.width(), m_size.height(), GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        endSlot(sequence, timestamp);
+    } else {
+        // Drop the frame rather than queue it behind one still being scaled
+        if (!m_scaling.testAndSetAcquire(0, 1))
+            return;
+
+        QImage image(m_frameSize, QImage::Format_ARGB32);
+        context->functions()->glReadPixels(0, 0, m_frameSize.width(), m_frameSize.height(), GL_RGBA, GL_UNSIGNED_BYTE, image.bits());
+        m_scaler.start(new FrameCaptureScaler(this, image, timestamp));
+    }
+
+    m_lastCapture = now;
+}
+
+bool FrameCaptureBuffer::createPixelBuffers(QOpenGLContext *context)
+{
+    // Pixel pack buffers and glMapBufferRange are core in OpenGL (ES) 3.0
+    QByteArray version(reinterpret_cast<const char *>(context->functions()->glGetString(GL_VERSION)));
+    if (version.startsWith("OpenGL ES "))
+        version = version.mid(10);
+    if (version.isEmpty() || version.at(0) < '3' || version.at(0) > '9')
+        return false;
+
+    m_mapBufferRange = reinterpret_cast<MapBufferRange>(context->getProcAddress("glMapBufferRange"));
+    m_unmapBuffer = reinterpret_cast<UnmapBuffer>(context->getProcAddress("glUnmapBuffer"));
+    if (!m_mapBufferRange || !m_unmapBuffer)
+        return false;
+
+    QOpenGLFunctions *functions = context->functions();
+    functions->glGenBuffers(2, m_pixelBuffers);
+    for (int ii = 0; ii < 2; ++ii) {
+        functions->glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixelBuffers[ii]);
+        functions->glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(m_frameSize.width()) * m_frameSize.height() * 4, 0, GL_STREAM_READ);
+    }
+    functions->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    return true;
+}
+
+void FrameCaptureBuffer::publishFrame(const uchar *pixels, quint64 timestamp)
+{
+    if (m_size == m_frameSize) {
+        quint64 sequence;
+        uchar *slotPixels = beginSlot(&sequence);
+        memcpy(slotPixels, pixels, size_t(m_stride) * m_size.height());
+        endSlot(sequence, timestamp);
+    } else {
+        // Drop the frame rather than queue it behind one still being scaled
+        if (!m_scaling.testAndSetAcquire(0, 1))
+            return;
+
+        QImage image(m_frameSize, QImage::Format_ARGB32);
+        memcpy(image.bits(), pixels, size_t(m_frameSize.width()) * m_frameSize.height() * 4);
+        m_scaler.start(new FrameCaptureScaler(this, image, timestamp));
+    }
+}
+
+void FrameCaptureBuffer::writeFrame(const QImage &image, quint64 timestamp)
+{
+    quint64 sequence;
+    uchar *pixels = beginSlot(&sequence);
+    for (int y = 0; y < m_size.height(); ++y)
+        memcpy(pixels + y * m_stride, image.constScanLine(y), m_stride);
+    endSlot(sequence, timestamp);
+}
+
+uchar *FrameCaptureBuffer::beginSlot(quint64 *sequence)
+{
+    FrameCaptureHeader *header = reinterpret_cast<FrameCaptureHeader *>(m_memory);
+    *sequence = header->sequence + 1;
+
+    uchar *slotMemory = m_memory + sizeof(FrameCaptureHeader) + ((*sequence - 1) % header->slotCount) * header->slotSize;
+    FrameCaptureSlot *slot = reinterpret_cast<FrameCaptureSlot *>(slotMemory);
+    __atomic_store_n(&slot->sequence, 0, __ATOMIC_RELAXED);
+    // Readers must see the slot marked before any of the new pixels
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    return slotMemory + sizeof(FrameCaptureSlot);
+}
+
+void FrameCaptureBuffer::endSlot(quint64 sequence, quint64 timestamp)
+{
+    FrameCaptureHeader *header = reinterpret_cast<FrameCaptureHeader *>(m_memory);
+    uchar *slotMemory = m_memory + sizeof(FrameCaptureHeader) + ((sequence - 1) % header->slotCount) * header->slotSize;
+    FrameCaptureSlot *slot = reinterpret_cast<FrameCaptureSlot *>(slotMemory);
+
+    slot->timestamp = timestamp;
+    __atomic_store_n(&slot->sequence, sequence, __ATOMIC_RELEASE);
+    __atomic_store_n(&header->sequence, sequence, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,124 @@
+/***************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd.
+**
+** This file is part of lipstick.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef FRAMECAPTUREBUFFER_H
+#define FRAMECAPTUREBUFFER_H
+
+#include <QSize>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QThreadPool>
+#include <QOpenGLFunctions>
+#include "lipstickglobal.h"
+
+class QImage;
+class QOpenGLContext;
+
+/*
+ * Layout of the shared memory a frame capture is published in. The file
+ * starts with a FrameCaptureHeader, followed by slotCount slots of slotSize
+ * bytes. Each slot starts with a FrameCaptureSlot and is followed by the
+ * frame, height rows of stride bytes of RGBA, bottom row first.
+ *
+ * A slot's sequence is 0 while it is being written and the number of the
+ * frame it holds afterwards; the header's sequence is the last frame
+ * written, stored in slot (sequence - 1) % slotCount. A reader loads the
+ * slot's sequence with acquire semantics, copies the pixels, issues an
+ * acquire fence (__atomic_thread_fence(__ATOMIC_ACQUIRE)) and loads the
+ * sequence again; if it changed or was 0, the frame was overwritten and has
+ * to be dropped. Writers never wait for readers.
+ */
+struct FrameCaptureHeader
+{
+    enum { Magic = 0x4246434c, Version = 1 };
+
+    quint32 magic;
+    quint32 version;
+    quint32 slotCount;
+    quint32 slotSize;
+    quint32 width;
+    quint32 height;
+    quint32 stride;
+    quint32 reserved;
+    quint64 sequence;
+};
+
+struct FrameCaptureSlot
+{
+    quint64 sequence;
+    // CLOCK_MONOTONIC, in nanoseconds, of the end of rendering the frame
+    quint64 timestamp;
+};
+
+/*!
+ * Publishes frames rendered by the compositor into a ring buffer in a
+ * memfd, which other processes map read only. Frames are captured on the
+ * render thread right after rendering; they are scaled on a worker thread
+ * if requested. Frames are dropped when they come faster than the maximum
+ * rate or while the previous one is still being scaled.
+ *
+ * Where the GL implementation has pixel pack buffers the readback is
+ * asynchronous: a frame is read into one of two buffers and published when
+ * the next frame is captured, so the render thread does not wait for the
+ * GPU. Otherwise the frame is read back and published right away.
+ */
+class LIPSTICK_EXPORT FrameCaptureBuffer
+{
+public:
+    FrameCaptureBuffer(const QSize &frameSize, qreal scale, qreal maxRate, int slotCount);
+    ~FrameCaptureBuffer();
+
+    bool isValid() const { return m_memory != 0; }
+    // Read only descriptor to hand out to clients
+    int fileDescriptor() const { return m_readOnlyFd; }
+
+    // Called on the render thread with the frame's context current. The
+    // buffer must be deleted there too, if a frame was captured.
+    void captureFrame();
+
+private:
+    typedef void *(QOPENGLF_APIENTRYP MapBufferRange)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+    typedef GLboolean (QOPENGLF_APIENTRYP UnmapBuffer)(GLenum target);
+
+    bool createPixelBuffers(QOpenGLContext *context);
+    void publishFrame(const uchar *pixels, quint64 timestamp);
+    void writeFrame(const QImage &image, quint64 timestamp);
+    uchar *beginSlot(quint64 *sequence);
+    void endSlot(quint64 sequence, quint64 timestamp);
+
+    friend class FrameCaptureScaler;
+
+    QSize m_frameSize;
+    QSize m_size;
+    int m_stride;
+    int m_fd;
+    int m_readOnlyFd;
+    size_t m_length;
+    uchar *m_memory;
+    qint64 m_minInterval;
+    qint64 m_lastCapture;
+    QElapsedTimer m_clock;
+    QAtomicInt m_scaling;
+    QThreadPool m_scaler;
+
+    enum Readback { ReadbackUnknown, ReadbackSynchronous, ReadbackPixelBuffers };
+    Readback m_readback;
+    GLuint m_pixelBuffers[2];
+    quint64 m_pixelBufferTimestamps[2];
+    int m_nextPixelBuffer;
+    MapBufferRange m_mapBufferRange;
+    UnmapBuffer m_unmapBuffer;
+};
+
+#endif // FRAMECAPTUREBUFFER_H
@@ -22,8 +22,17 @@
 #include <QtSensors/QOrientationSensor>
 #include <QClipboard>
 #include <QMimeData>
+#include <QScreen>
+#include <QSettings>
+#include <QFile>
+#include <QFileInfo>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
 #include "homeapplication.h"
 #include "windowmodel.h"
+#include "windowproperty.h"
+#include "memorypressuremonitor.h"
+#include "framecapturebuffer.h"
 #include "lipstickcompositorprocwindow.h"
 #include "lipstickcompositor.h"
 #include <qpa/qwindowsysteminterface.h>
@@ -31,18 +40,73 @@
 LipstickCompositor *LipstickCompositor::m_instance = 0;
 
 LipstickCompositor::LipstickCompositor()
-: QWaylandCompositor(this), m_totalWindowCount(0), m_nextWindowId(1), m_homeActive(true), m_shaderEffect(0),
-  m_fullscreenSurface(0), m_directRenderingActive(false), m_topmostWindowId(0), m_screenOrientation(Qt::PrimaryOrientation), m_displayState(new MeeGo::QmDisplayState(this)), m_retainedSelection(0)
+: QWaylandCompositor(this), m_totalWindowCount(0), m_memoryPressureMonitor(new MemoryPressureMonitor(this)),
+  m_windowBufferBudget(0), m_reaperThreshold(0), m_reaperKillTimeout(0),
+  m_touchCoalescing(true), m_touchPrediction(false), m_statisticsSubscribers(0), m_nextWindowId(1), m_homeActive(true),
+  m_fullscreenSurface(0), m_directRenderingActive(false), m_topmostWindowId(0), m_screenOrientation(Qt::PrimaryOrientation), m_displayState(new MeeGo::QmDisplayState(this)),
+  m_displayStateOff(false), m_updatesEnabled(true), m_damagedWhileDisplayOff(false),
+  m_displayAboutToBeOnTime(0),
+  m_syncStartTime(0), m_lastSwapTime(0), m_frameInterval(16667), m_renderTime(0),
+  m_frameMargin(2000), m_frameCallbackBudget(0), m_nextFrameGrab(0),
+  m_frameCapture(0), m_retainedSelection(0), m_clipboardFormatLimit(0)
 {
     setColor(Qt::black);
     setRetainedSelectionEnabled(true);
 
+    // Largest clipboard data, in kilobytes, retained per format; 0, the
+    // default, for no limit. Formats over the limit can't be pasted.
+    m_clipboardFormatLimit = qgetenv("LIPSTICK_COMPOSITOR_CLIPBOARD_LIMIT").toInt() * 1024;
+
     if (m_instance) qFatal("LipstickCompositor: Only one compositor instance per process is supported");
     m_instance = this;
 
     QObject::connect(this, SIGNAL(frameSwapped()), this, SLOT(windowSwapped()));
     QObject::connect(this, SIGNAL(beforeSynchronizing()), this, SLOT(clearUpdateRequest()));
+
+    // Frame timing is sampled on the render thread itself, so that the
+    // timestamps are not skewed by the GUI thread event queue
+    QObject::connect(this, SIGNAL(beforeSynchronizing()), this, SLOT(frameSyncStarted()), Qt::DirectConnection);
+    QObject::connect(this, SIGNAL(afterRendering()), this, SLOT(frameRenderedOnRenderThread()), Qt::DirectConnection);
+    QObject::connect(this, SIGNAL(frameSwapped()), this, SLOT(frameSwappedOnRenderThread()), Qt::DirectConnection);
+    QObject::connect(this, SIGNAL(afterRendering()), this, SLOT(grabFrameOnRenderThread()), Qt::DirectConnection);
+
+    if (qApp->primaryScreen() && qApp->primaryScreen()->refreshRate() > 0)
+        m_frameInterval = 1000000 / qApp->primaryScreen()->refreshRate();
+
+    // Time, in milliseconds, kept free before a vsync on top of the measured render time
+    QByteArray margin = qgetenv("LIPSTICK_COMPOSITOR_FRAME_MARGIN");
+    if (!margin.isEmpty())
+        m_frameMargin = margin.toInt() * 1000;
+
+    // Time, in milliseconds, given to clients between their frame callback and the
+    // start of composition. 0 sends frame callbacks as soon as a frame is swapped.
+    m_frameCallbackBudget = qgetenv("LIPSTICK_COMPOSITOR_FRAME_CALLBACK_BUDGET").toInt() * 1000;
+
+    m_frameClock.start();
+
+    // Megabytes of full size window buffers kept for windows not on screen,
+    // 0 only trims on memory pressure
+    m_windowBufferBudget = qgetenv("LIPSTICK_COMPOSITOR_BUFFER_BUDGET").toLongLong() * 1024 * 1024;
+    connect(m_memoryPressureMonitor, SIGNAL(memoryPressure()), this, SLOT(releaseWindowBuffers()));
+
+    loadReaperSettings();
+    loadTouchSettings();
+    m_touchFlushTimer.setTimerType(Qt::PreciseTimer);
+    m_touchFlushTimer.setSingleShot(true);
+    QObject::connect(&m_touchFlushTimer, SIGNAL(timeout()), this, SLOT(flushTouchEvents()));
+
+    // Only runs while someone is subscribed to the window statistics
+    m_statisticsTimer.setInterval(1000);
+    QObject::connect(&m_statisticsTimer, SIGNAL(timeout()), this, SLOT(sampleWindowStatistics()));
+    connect(m_memoryPressureMonitor, SIGNAL(memoryPressure()), this, SLOT(reapBackgroundApplications()));
+    m_frameTimer.setTimerType(Qt::PreciseTimer);
+    m_frameTimer.setSingleShot(true);
+    QObject::connect(&m_frameTimer, SIGNAL(timeout()), this, SLOT(startFrame()));
+    m_frameCallbackTimer.setTimerType(Qt::PreciseTimer);
+    m_frameCallbackTimer.setSingleShot(true);
+    QObject::connect(&m_frameCallbackTimer, SIGNAL(timeout()), this, SLOT(sendFrameCallbacks()));
     connect(m_displayState, SIGNAL(displayStateChanged(MeeGo::QmDisplayState::DisplayState)), this, SLOT(reactOnDisplayStateChanges(MeeGo::QmDisplayState::DisplayState)));
+    connect(this, SIGNAL(displayAboutToBeOn()), this, SLOT(prepareDisplayOn()));
     QObject::connect(HomeApplication::instance(), SIGNAL(aboutToDestroy()), this, SLOT(homeApplicationAboutToDestroy()));
 
     m_orientationSensor = new QOrientationSensor(this);
@@ -64,7 +128,9 @@ LipstickCompositor::LipstickCompositor()
 
 LipstickCompositor::~LipstickCompositor()
 {
-    delete m_shaderEffect;
+    // The GL resources of the buffers went with the render thread's context
+    delete m_frameCapture;
+    qDeleteAll(m_retiredFrameCaptures);
 }
 
 LipstickCompositor *LipstickCompositor::instance()
@@ -94,7 +160,7 @@ void LipstickCompositor::surfaceCreated(QWaylandSurface *surface)
     connect(surface, SIGNAL(unmapped()), this, SLOT(surfaceUnmapped()));
     connect(surface, SIGNAL(sizeChanged()), this, SLOT(surfaceSizeChanged()));
     connect(surface, SIGNAL(titleChanged()), this, SLOT(surfaceTitleChanged()));
-    connect(surface, SIGNAL(windowPropertyChanged(QString,QVariant)), this, SLOT(windowPropertyChanged(QString)));
+    connect(surface, SIGNAL(windowPropertyChanged(QString,QVariant)), this, SLOT(windowPropertyChanged(QString,QVariant)));
     connect(surface, SIGNAL(raiseRequested()), this, SLOT(surfaceRaised()));
     connect(surface, SIGNAL(lowerRequested()), this, SLOT(surfaceLowered()));
     connect(surface, SIGNAL(damaged(QRect)), this, SLOT(surfaceDamaged(QRect)));
@@ -119,15 +185,54 @@ void LipstickCompositor::openUrl(const QUrl &url)
 #endif
 }
 
+namespace {
+
+QStringList processArguments(qint64 pid)
+{
+    QFile file(QString("/proc/%1/cmdline").arg(pid));
+    if (!file.open(QIODevice::ReadOnly))
+        return QStringList();
+
+    // Command line arguments are split by '\0' in /proc/*/cmdline
+    QStringList arguments;
+    foreach (const QByteArray &argument, file.readAll().split('\0')) {
+        if (!argument.isEmpty())
+            arguments.append(QString::fromLocal8Bit(argument));
+    }
+    return arguments;
+}
+
+QString processExecutable(const QStringList &arguments)
+{
+    return arguments.isEmpty() ? QString() : QFileInfo(arguments.first()).fileName();
+}
+
+// Command lines are indexed by each of their leading argument lists; the
+// separator cannot appear inside an argument
+QString commandKey(const QStringList &arguments, int count)
+{
+    return QStringList(arguments.mid(0, count)).join(QChar('\0'));
+}
+
+}
+
 void LipstickCompositor::retainedSelectionReceived(QMimeData *mimeData)
 {
     if (!m_retainedSelection)
         m_retainedSelection = new QMimeData;
 
-    // Make a copy to allow QClipboard to take ownership of our data
+    // Make a copy to allow QClipboard to take ownership of our data. The copy
+    // is shallow, the data stays shared with the received selection; formats
+    // over the size limit are left out rather than kept alive.
     m_retainedSelection->clear();
-    foreach (const QString &format, mimeData->formats())
-        m_retainedSelection->setData(format, mimeData->data(format));
+    foreach (const QString &format, mimeData->formats()) {
+        QByteArray data = mimeData->data(format);
+        if (m_clipboardFormatLimit > 0 && data.size() > m_clipboardFormatLimit) {
+            qWarning() << "Not retaining" << data.size() << "bytes of clipboard data in" << format;
+            continue;
+        }
+        m_retainedSelection->setData(format, data);
+    }
 
     QGuiApplication::clipboard()->setMimeData(m_retainedSelection.data());
 }
@@ -154,6 +259,15 @@ void LipstickCompositor::setHomeActive(bool a)
 
     m_homeActive = a;
 
+    // Covers updated on activation get one frame each, and clients throttled
+    // for their covers are released when home is left
+    if (m_homeActive) {
+        foreach (LipstickCompositorWindow *window, m_windows)
+            window->m_coverRefreshPending = true;
+    }
+    if (!displayOff())
+        sendFrameCallbacks();
+
     emit homeActiveChanged();
     emit HomeApplication::instance()->homeActiveChanged();
 }
@@ -189,19 +303,153 @@ QWaylandSurface *LipstickCompositor::surfaceForId(int id) const
     return window?window->surface():0;
 }
 
-int LipstickCompositor::windowIdForLink(QWaylandSurface *s, uint link) const
+uint LipstickCompositor::windowNotificationPreviewsDisabled(int id) const
 {
-    for (QHash<int, LipstickCompositorWindow *>::ConstIterator iter = m_mappedSurfaces.begin();
-         iter != m_mappedSurfaces.end(); ++iter) {
+    LipstickCompositorWindow *window = m_mappedSurfaces.value(id, 0);
+    return window ? window->notificationPreviewsDisabled() : 0;
+}
+
+QList<int> LipstickCompositor::windowIdsForProcessId(qint64 processId) const
+{
+    return m_windowIdsByProcessId.values(processId);
+}
+
+QList<int> LipstickCompositor::windowIdsForCategory(const QString &category) const
+{
+    return m_windowIdsByCategory.values(category);
+}
+
+QList<int> LipstickCompositor::windowIdsForCommand(const QString &command) const
+{
+    QStringList arguments = command.simplified().split(QLatin1Char(' '), QString::SkipEmptyParts);
+    if (arguments.isEmpty())
+        return QList<int>();
+
+    return m_windowIdsByCommand.values(commandKey(arguments, arguments.count()));
+}
+
+QList<int> LipstickCompositor::windowIdsForDesktopFile(const QString &desktopFileId) const
+{
+    return m_windowIdsByDesktopFile.values(desktopFileId);
+}
+
+QString LipstickCompositor::commandApplication(const QStringList &arguments)
+{
+    static const QStringList runtimes = QStringList() << "invoker" << "sailfish-qml" << "qmlscene"
+                                                      << "python" << "python3";
+
+    QString executable = processExecutable(arguments);
+    if (!runtimes.contains(executable))
+        return executable;
+
+    for (int ii = 1; ii < arguments.count(); ++ii) {
+        const QString &argument = arguments.at(ii);
+        if (argument == QLatin1String("--"))
+            return commandApplication(arguments.mid(ii + 1));
+        else if (!argument.startsWith(QLatin1Char('-')))
+            return commandApplication(arguments.mid(ii));
+    }
+    return QString();
+}
+
+void LipstickCompositor::registerWindow(LipstickCompositorWindow *window)
+{
+    int id = window->windowId();
+
+    m_mappedSurfaces.insert(id, window);
+    if (window->processId())
+        m_windowIdsByProcessId.insert(window->processId(), id);
+    m_windowIdsByCategory.insert(window->category(), id);
+    for (int ii = 1; ii <= window->m_arguments.count(); ++ii)
+        m_windowIdsByCommand.insert(commandKey(window->m_arguments, ii), id);
+    QString application = commandApplication(window->m_arguments);
+    if (!application.isEmpty())
+        m_windowIdsByDesktopFile.insert(application + QLatin1String(".desktop"), id);
+    if (!window->m_winId)
+        return;
+
+    QPair<qint64, uint> link = qMakePair(window->processId(), window->m_winId);
+    m_windowIdsByLink.insert(link, id);
 
-        QWaylandSurface *windowSurface = iter.value()->surface();
+    // Wake only the window properties that were waiting for this window
+    QList<QPointer<WindowProperty> > waiting;
+    foreach (WindowProperty *property, m_pendingWindowLinks.values(link)) {
+        m_resolvedWindowLinks.insert(id, property);
+        waiting.append(property);
+    }
+    m_pendingWindowLinks.remove(link);
+
+    foreach (const QPointer<WindowProperty> &property, waiting) {
+        if (property)
+            property->setLinkedWindowId(id);
+    }
+}
 
-        if (windowSurface && windowSurface->processId() == s->processId() &&
-            windowSurface->windowProperties().value("WINID", uint(0)).toUInt() == link)
-            return iter.value()->windowId();
+void LipstickCompositor::unregisterWindow(LipstickCompositorWindow *window)
+{
+    int id = window->windowId();
+
+    m_mappedSurfaces.remove(id);
+    m_windowIdsByProcessId.remove(window->processId(), id);
+    m_windowIdsByCategory.remove(window->category(), id);
+    for (int ii = 1; ii <= window->m_arguments.count(); ++ii)
+        m_windowIdsByCommand.remove(commandKey(window->m_arguments, ii), id);
+    QString application = commandApplication(window->m_arguments);
+    if (!application.isEmpty())
+        m_windowIdsByDesktopFile.remove(application + QLatin1String(".desktop"), id);
+    if (window->m_winId && m_windowIdsByLink.value(qMakePair(window->processId(), window->m_winId)) == id)
+        m_windowIdsByLink.remove(qMakePair(window->processId(), window->m_winId));
+
+    // Properties that resolved to this window go back to waiting for their link
+    QList<QPointer<WindowProperty> > linked;
+    foreach (WindowProperty *property, m_resolvedWindowLinks.values(id)) {
+        m_pendingWindowLinks.insert(qMakePair(property->m_linkProcessId, property->m_link), property);
+        linked.append(property);
     }
+    m_resolvedWindowLinks.remove(id);
 
-    return 0;
+    foreach (const QPointer<WindowProperty> &property, linked) {
+        if (property)
+            property->setLinkedWindowId(0);
+    }
+}
+
+void LipstickCompositor::setWindowLink(LipstickCompositorWindow *window, uint winId)
+{
+    if (window->m_winId == winId)
+        return;
+
+    bool registered = m_mappedSurfaces.value(window->windowId()) == window;
+    if (registered)
+        unregisterWindow(window);
+
+    window->m_winId = winId;
+
+    if (registered)
+        registerWindow(window);
+
+    emit window->winIdChanged();
+}
+
+int LipstickCompositor::acquireWindowLink(WindowProperty *property)
+{
+    QPair<qint64, uint> link = qMakePair(property->m_linkProcessId, property->m_link);
+    int id = m_windowIdsByLink.value(link, 0);
+
+    if (id)
+        m_resolvedWindowLinks.insert(id, property);
+    else
+        m_pendingWindowLinks.insert(link, property);
+
+    return id;
+}
+
+void LipstickCompositor::releaseWindowLink(WindowProperty *property)
+{
+    if (property->m_linkedWindowId)
+        m_resolvedWindowLinks.remove(property->m_linkedWindowId, property);
+    else if (property->m_link)
+        m_pendingWindowLinks.remove(qMakePair(property->m_linkProcessId, property->m_link), property);
 }
 
 void LipstickCompositor::clearKeyboardFocus()
@@ -214,11 +462,24 @@ void LipstickCompositor::setDisplayOff()
     m_displayState->set(MeeGo::QmDisplayState::Off);
 }
 
-void LipstickCompositor::surfaceDamaged(const QRect &)
+void LipstickCompositor::surfaceDamaged(const QRect &rect)
 {
-    if (!isVisible()) {
+    QWaylandSurface *surface = qobject_cast<QWaylandSurface *>(sender());
+    LipstickCompositorWindow *window = surface ? static_cast<LipstickCompositorWindow *>(surface->surfaceItem()) : 0;
+    if (window) {
+        ++window->m_statistics.commits;
+        window->m_statistics.damagedPixels += quint64(rect.width()) * rect.height();
+        window->m_frameCallbackPending = true;
+    }
+
+    if (displayOff()) {
+        // Hold the frame callbacks until the display is back on, so that
+        // clients stop animating into a dark screen
+        m_damagedWhileDisplayOff = true;
+    } else if (!isVisible()) {
         // If the compositor is not visible, do not throttle.
         // make it conditional to QT_WAYLAND_COMPOSITOR_NO_THROTTLE?
+        countFrameCallbacks(0);
         frameFinished(0);
     }
 }
@@ -254,6 +515,11 @@ void LipstickCompositor::setTopmostWindowId(int id)
 {
     if (id != m_topmostWindowId) {
         m_topmostWindowId = id;
+
+        LipstickCompositorWindow *window = m_mappedSurfaces.value(id, 0);
+        if (window)
+            setWindowViewed(window);
+
         emit topmostWindowIdChanged();
     }
 }
@@ -271,7 +537,7 @@ void LipstickCompositor::surfaceAboutToBeDestroyed(QWaylandSurface *surface)
         int id = item->windowId();
 
         int gc = ghostWindowCount();
-        m_mappedSurfaces.remove(item->windowId());
+        unregisterWindow(item);
 
         emit windowCountChanged();
         emit windowRemoved(item);
@@ -297,10 +563,445 @@ void LipstickCompositor::clearUpdateRequest()
 void LipstickCompositor::maybePostUpdateRequest()
 {
     // Called from GUI thread
-    if (m_updateRequestPosted.testAndSetOrdered(0, 1))
+    if (displayOff()) {
+        m_damagedWhileDisplayOff = true;
+        return;
+    }
+
+    if (!m_updateRequestPosted.testAndSetOrdered(0, 1))
+        return;
+
+    // Start the frame as late as the next vsync allows, so that buffers
+    // committed in the meantime still make it into this frame
+    int delay = frameDelay();
+    if (delay > 0)
+        m_frameTimer.start(delay);
+    else
         qApp->postEvent(this, new QEvent(QEvent::User));
 }
 
+void LipstickCompositor::startFrame()
+{
+    // Motion gathered since the last frame goes out with it
+    flushTouchEvents();
+
+    // Surface state staged since the last frame is applied before the scene
+    // graph is synchronized. This has to happen here on the GUI thread rather
+    // than in beforeSynchronizing, which is emitted on the render thread.
+    applySurfaceChanges();
+
+    if (displayOff())
+        return;
+
+    update();
+}
+
+void LipstickCompositor::scheduleTouchFlush(LipstickCompositorWindow *window)
+{
+    m_pendingTouchWindows.insert(window);
+
+    // Flush at the latest when the next frame would start, even if nothing is
+    // being composited at the moment
+    if (!m_touchFlushTimer.isActive())
+        m_touchFlushTimer.start(frameDelay());
+}
+
+void LipstickCompositor::flushTouchEvents()
+{
+    m_touchFlushTimer.stop();
+
+    QSet<LipstickCompositorWindow *> windows = m_pendingTouchWindows;
+    m_pendingTouchWindows.clear();
+    foreach (LipstickCompositorWindow *window, windows)
+        window->flushTouchEvent();
+}
+
+void LipstickCompositor::stageSurfaceChange(LipstickCompositorWindow *window)
+{
+    m_pendingSurfaceChanges.insert(window);
+
+    // Without frames nothing would pick the change up
+    if (displayOff())
+        applySurfaceChanges();
+    else
+        maybePostUpdateRequest();
+}
+
+void LipstickCompositor::applySurfaceChanges()
+{
+    if (m_pendingSurfaceChanges.isEmpty())
+        return;
+
+    QSet<LipstickCompositorWindow *> windows = m_pendingSurfaceChanges;
+    m_pendingSurfaceChanges.clear();
+
+    bool sizeChanged = false;
+    foreach (LipstickCompositorWindow *window, windows) {
+        sizeChanged |= window->m_sizePending;
+        window->applyPendingChanges();
+
+        if (window->m_titlePending) {
+            window->m_titlePending = false;
+            emit window->titleChanged();
+
+            int windowId = window->windowId();
+            for (int ii = 0; ii < m_windowModels.count(); ++ii)
+                m_windowModels.at(ii)->titleChanged(windowId);
+        }
+    }
+
+    if (sizeChanged)
+        checkWindowBufferBudget();
+}
+
+void LipstickCompositor::frameSyncStarted()
+{
+    // Called from render thread
+    QMutexLocker locker(&m_frameTimingMutex);
+    m_syncStartTime = m_frameClock.nsecsElapsed() / 1000;
+}
+
+void LipstickCompositor::frameRenderedOnRenderThread()
+{
+    // Called from render thread. The swap blocks on vsync, so the render time
+    // ends when the scene graph has issued its commands, not at frameSwapped.
+    qint64 now = m_frameClock.nsecsElapsed() / 1000;
+
+    QMutexLocker locker(&m_frameTimingMutex);
+    if (!m_syncStartTime)
+        return;
+
+    // Follow render time increases immediately and decreases slowly, a late
+    // start costs a whole frame
+    qint64 renderTime = now - m_syncStartTime;
+    m_renderTime = qMax(renderTime, (3 * m_renderTime + renderTime) / 4);
+    m_syncStartTime = 0;
+}
+
+void LipstickCompositor::frameSwappedOnRenderThread()
+{
+    // Called from render thread
+    qint64 now = m_frameClock.nsecsElapsed() / 1000;
+
+    QMutexLocker locker(&m_frameTimingMutex);
+
+    // Only back to back frames tell something about the refresh interval
+    qint64 interval = now - m_lastSwapTime;
+    if (m_lastSwapTime && interval > m_frameInterval / 2 && interval < m_frameInterval * 3 / 2)
+        m_frameInterval = (7 * m_frameInterval + interval) / 8;
+
+    m_lastSwapTime = now;
+}
+
+int LipstickCompositor::requestFrameGrab(const QRect &region)
+{
+    if (displayOff() || !isVisible())
+        return -1;
+
+    // The region is in logical coordinates, the frame is read in device pixels
+    qreal ratio = devicePixelRatio();
+    QRect deviceRegion(region.topLeft() * ratio, region.size() * ratio);
+
+    QMutexLocker locker(&m_frameGrabMutex);
+    int request = m_nextFrameGrab++;
+    m_frameGrabRequests.append(qMakePair(request, deviceRegion));
+    m_frameGrabsPending.storeRelease(1);
+    locker.unlock();
+
+    maybePostUpdateRequest();
+
+    return request;
+}
+
+void LipstickCompositor::setFrameCapture(FrameCaptureBuffer *buffer)
+{
+    // Waits for a capture in progress on the render thread
+    QMutexLocker locker(&m_frameGrabMutex);
+    if (m_frameCapture)
+        m_retiredFrameCaptures.append(m_frameCapture);
+    m_frameCapture = buffer;
+    m_frameCaptureActive.storeRelease(m_frameCapture != 0 || !m_retiredFrameCaptures.isEmpty());
+    bool retired = !m_retiredFrameCaptures.isEmpty();
+    locker.unlock();
+
+    // Let the render thread release the old buffer
+    if (retired)
+        maybePostUpdateRequest();
+}
+
+void LipstickCompositor::grabFrameOnRenderThread()
+{
+    // Called from render thread, after every frame
+    if (m_frameCaptureActive.loadAcquire()) {
+        QMutexLocker locker(&m_frameGrabMutex);
+        qDeleteAll(m_retiredFrameCaptures);
+        m_retiredFrameCaptures.clear();
+        if (m_frameCapture)
+            m_frameCapture->captureFrame();
+        else
+            m_frameCaptureActive.storeRelease(0);
+    }
+
+    if (!m_frameGrabsPending.loadAcquire())
+        return;
+
+    QMutexLocker locker(&m_frameGrabMutex);
+    QList<QPair<int, QRect> > requests = m_frameGrabRequests;
+    m_frameGrabRequests.clear();
+    m_frameGrabsPending.storeRelease(0);
+    locker.unlock();
+
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    QSize size = this->size() * devicePixelRatio();
+
+    for (int ii = 0; ii < requests.count(); ++ii) {
+        QRect region = requests.at(ii).second.intersected(QRect(QPoint(), size));
+        QImage image;
+        if (context && !region.isEmpty()) {
+            // Only the read itself stalls the render thread; converting the
+            // rows is left to the receiver
+            image = QImage(region.size(), QImage::Format_ARGB32);
+            context->functions()->glReadPixels(region.x(), size.height() - region.y() - region.height(),
+                                               region.width(), region.height(),
+                                               GL_RGBA, GL_UNSIGNED_BYTE, image.bits());
+        }
+        emit frameGrabbed(requests.at(ii).first, image);
+    }
+}
+
+void LipstickCompositor::setWindowViewed(LipstickCompositorWindow *window)
+{
+    window->m_lastViewed = m_frameClock.elapsed();
+    setWindowDowngraded(window, false);
+}
+
+void LipstickCompositor::setWindowDowngraded(LipstickCompositorWindow *window, bool downgraded)
+{
+    if (window->m_downgraded == downgraded)
+        return;
+
+    if (debug())
+        qDebug() << "Window" << window->windowId() << (downgraded ? "downgraded to thumbnail" : "restored");
+
+    window->m_downgraded = downgraded;
+    emit window->downgradedChanged();
+}
+
+void LipstickCompositor::checkWindowBufferBudget()
+{
+    if (m_windowBufferBudget)
+        trimWindowBuffers(m_windowBufferBudget);
+}
+
+void LipstickCompositor::releaseWindowBuffers()
+{
+    if (debug())
+        qDebug() << "Memory pressure, releasing window buffers";
+
+    trimWindowBuffers(0);
+}
+
+bool LipstickCompositor::viewedBefore(LipstickCompositorWindow *a, LipstickCompositorWindow *b)
+{
+    return a->m_lastViewed < b->m_lastViewed;
+}
+
+void LipstickCompositor::trimWindowBuffers(qint64 target)
+{
+    // Downgrade the least recently viewed windows to their thumbnails until the
+    // full size buffers still held fit the target. Only closed windows kept
+    // for their covers are downgraded: their covers then let go of them and
+    // the buffers are freed. A live client's surface item keeps holding its
+    // buffer, so downgrading it would only add a thumbnail on top.
+    QList<LipstickCompositorWindow *> candidates;
+    qint64 total = 0;
+
+    foreach (LipstickCompositorWindow *window, m_windows) {
+        if (window->m_downgraded)
+            continue;
+
+        total += window->bufferBytes();
+
+        if (window->m_windowClosed && !window->isInProcess())
+            candidates.append(window);
+    }
+
+    if (total <= target)
+        return;
+
+    qSort(candidates.begin(), candidates.end(), viewedBefore);
+
+    foreach (LipstickCompositorWindow *window, candidates) {
+        if (total <= target)
+            break;
+
+        total -= window->bufferBytes();
+        setWindowDowngraded(window, true);
+    }
+}
+
+namespace {
+
+// Returns the value of a "Key:  1234 kB" line, in kilobytes, or -1
+qint64 readKilobytes(const QString &fileName, const QByteArray &key)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+
+    QByteArray line;
+    while (!(line = file.readLine()).isEmpty()) {
+        if (line.startsWith(key))
+            return line.mid(key.length()).trimmed().split(' ').first().toLongLong();
+    }
+
+    return -1;
+}
+
+}
+
+void LipstickCompositor::loadReaperSettings()
+{
+    QSettings settings("/usr/share/lipstick/lipstick.conf", QSettings::IniFormat);
+    settings.beginGroup("reaper");
+    // Available memory, in megabytes, below which background applications are
+    // terminated. Off unless the device configuration sets a threshold.
+    m_reaperThreshold = settings.value("memoryThreshold", 0).toLongLong() * 1024;
+    m_reaperKillTimeout = settings.value("killTimeout", 3000).toInt();
+    m_reaperProtected = settings.value("protected").toStringList();
+}
+
+void LipstickCompositor::loadTouchSettings()
+{
+    // Touch motion is coalesced to one update per frame unless disabled, either
+    // in general or for a window category in a subgroup named after it
+    QSettings settings("/usr/share/lipstick/lipstick.conf", QSettings::IniFormat);
+    settings.beginGroup("touch");
+    m_touchCoalescing = settings.value("coalesce", true).toBool();
+    m_touchPrediction = settings.value("predict", false).toBool();
+    foreach (const QString &category, settings.childGroups()) {
+        settings.beginGroup(category);
+        m_touchCoalescingByCategory.insert(category, settings.value("coalesce", m_touchCoalescing).toBool());
+        m_touchPredictionByCategory.insert(category, settings.value("predict", m_touchPrediction).toBool());
+        settings.endGroup();
+    }
+}
+
+void LipstickCompositor::reapBackgroundApplications()
+{
+    if (!m_reaperThreshold)
+        return;
+
+    qint64 available = readKilobytes("/proc/meminfo", "MemAvailable:");
+    if (available < 0 || available >= m_reaperThreshold)
+        return;
+
+    // A process counts as recently used as its most recently viewed window,
+    // and is left alone while any of its windows is on screen
+    QHash<qint64, LipstickCompositorWindow *> processes;
+    QSet<qint64> visible;
+    foreach (LipstickCompositorWindow *window, m_mappedSurfaces) {
+        qint64 pid = window->processId();
+        if (!pid || pid == QCoreApplication::applicationPid() || window->isInProcess())
+            continue;
+
+        if (window->windowId() == m_topmostWindowId ||
+            (m_fullscreenSurface && window->surface() == m_fullscreenSurface))
+            visible.insert(pid);
+
+        LipstickCompositorWindow *newest = processes.value(pid, 0);
+        if (!newest || viewedBefore(newest, window))
+            processes.insert(pid, window);
+    }
+
+    QList<LipstickCompositorWindow *> candidates = processes.values();
+    qSort(candidates.begin(), candidates.end(), viewedBefore);
+
+    foreach (LipstickCompositorWindow *window, candidates) {
+        if (available >= m_reaperThreshold)
+            break;
+
+        qint64 pid = window->processId();
+        if (visible.contains(pid))
+            continue;
+
+        QString executable = processExecutable(window->m_arguments);
+        if (m_reaperProtected.contains(executable))
+            continue;
+
+        QString smaps = QString("/proc/%1/smaps_rollup").arg(pid);
+        qint64 pss = readKilobytes(smaps, "Pss:");
+        qint64 rss = readKilobytes(smaps, "Rss:");
+
+        QString reason = QString("Available memory %1 kB below %2 kB; Pss %3 kB, Rss %4 kB, last viewed %5 s ago")
+                .arg(available).arg(m_reaperThreshold).arg(pss).arg(rss)
+                .arg((m_frameClock.elapsed() - window->m_lastViewed) / 1000);
+
+        qWarning() << "Terminating background application" << pid << executable << "-" << reason;
+        emit HomeApplication::instance()->applicationReaped(pid, executable, reason);
+
+        window->terminateProcess(m_reaperKillTimeout);
+
+        if (pss > 0)
+            available += pss;
+    }
+}
+
+qint64 LipstickCompositor::nextFrameDeadline(qint64 now)
+{
+    // Returns the latest time at which a frame can be started and still be
+    // shown on the next vsync, or 0 if the vsync phase is not known
+    QMutexLocker locker(&m_frameTimingMutex);
+
+    if (!m_lastSwapTime || now - m_lastSwapTime > 4 * m_frameInterval)
+        return 0;
+
+    qint64 lead = m_renderTime + m_frameMargin;
+    qint64 vsync = m_lastSwapTime + m_frameInterval;
+    while (vsync - lead < now)
+        vsync += m_frameInterval;
+
+    return vsync - lead;
+}
+
+int LipstickCompositor::frameDelay()
+{
+    qint64 now = m_frameClock.nsecsElapsed() / 1000;
+    qint64 deadline = nextFrameDeadline(now);
+
+    // Idle for a while; there is nothing to align to, so start right away
+    if (!deadline)
+        return 0;
+
+    return (deadline - now) / 1000;
+}
+
+int LipstickCompositor::frameCallbackDelay()
+{
+    if (!m_frameCallbackBudget)
+        return 0;
+
+    qint64 now = m_frameClock.nsecsElapsed() / 1000;
+    qint64 deadline = nextFrameDeadline(now);
+    if (!deadline)
+        return 0;
+
+    return qMax<qint64>(0, deadline - m_frameCallbackBudget - now) / 1000;
+}
+
+int LipstickCompositor::presentationDelay()
+{
+    // Milliseconds until the vsync at which a frame committed by a client now
+    // is presented, at most one frame interval
+    qint64 now = m_frameClock.nsecsElapsed() / 1000;
+    qint64 deadline = nextFrameDeadline(now);
+    if (!deadline)
+        return m_frameInterval / 1000;
+
+    QMutexLocker locker(&m_frameTimingMutex);
+    return qMin(deadline + m_renderTime + m_frameMargin - now, m_frameInterval) / 1000;
+}
+
 void LipstickCompositor::surfaceMapped()
 {
     QWaylandSurface *surface = qobject_cast<QWaylandSurface *>(sender());
@@ -308,27 +1009,38 @@ void LipstickCompositor::surfaceMapped()
     if (!surface->hasShellSurface())
         return;
 
-    QVariantMap properties = surface->windowProperties();
-    QString category = properties.value("CATEGORY").toString();
-
     if (surface->surfaceItem()) {
         // Always cause a repaint on surface mapped
         maybePostUpdateRequest();
         return;
     }
 
-    // The surface was mapped for the first time
+    // The surface was mapped for the first time; the category is fixed from here on
+    QString category = surface->windowProperties().value("CATEGORY").toString();
     int id = m_nextWindowId++;
     LipstickCompositorWindow *item = new LipstickCompositorWindow(id, category, surface, contentItem());
     item->setSize(surface->size());
     QObject::connect(item, SIGNAL(destroyed(QObject*)), this, SLOT(windowDestroyed()));
 
+    // The command line is read once here; other windows of the same process share it
+    if (qint64 pid = item->processId()) {
+        QList<int> siblings = m_windowIdsByProcessId.values(pid);
+        if (!siblings.isEmpty())
+            item->m_arguments = m_mappedSurfaces.value(siblings.first())->m_arguments;
+        else
+            item->m_arguments = processArguments(pid);
+    }
+
     // Whenever the item is damaged, cause a full repaint
     QObject::connect(item, SIGNAL(textureChanged()), this, SLOT(maybePostUpdateRequest()));
     m_totalWindowCount++;
-    m_mappedSurfaces.insert(id, item);
+    m_windows.insert(item);
+    registerWindow(item);
+    setWindowViewed(item);
 
     item->setTouchEventsEnabled(true);
+    item->m_coalesceTouch = m_touchCoalescingByCategory.value(category, m_touchCoalescing);
+    item->m_predictTouch = item->m_coalesceTouch && m_touchPredictionByCategory.value(category, m_touchPrediction);
 
     emit windowCountChanged();
     emit windowAdded(item);
@@ -336,6 +1048,9 @@ void LipstickCompositor::surfaceMapped()
     windowAdded(id);
 
     emit availableWinIdsChanged();
+
+    checkWindowBufferBudget();
+    reapBackgroundApplications();
 }
 
 void LipstickCompositor::surfaceUnmapped()
@@ -348,8 +1063,10 @@ void LipstickCompositor::surfaceSizeChanged()
     QWaylandSurface *surface = qobject_cast<QWaylandSurface *>(sender());
 
     LipstickCompositorWindow *window = static_cast<LipstickCompositorWindow *>(surface->surfaceItem());
-    if (window)
-        window->setSize(surface->size());
+    if (window) {
+        window->m_sizePending = true;
+        stageSurfaceChange(window);
+    }
 }
 
 void LipstickCompositor::surfaceTitleChanged()
@@ -358,12 +1075,8 @@ void LipstickCompositor::surfaceTitleChanged()
     LipstickCompositorWindow *window = static_cast<LipstickCompositorWindow *>(surface->surfaceItem());
 
     if (window) {
-        emit window->titleChanged();
-
-        int windowId = window->windowId();
-
-        for (int ii = 0; ii < m_windowModels.count(); ++ii)
-            m_windowModels.at(ii)->titleChanged(windowId);
+        window->m_titlePending = true;
+        stageSurfaceChange(window);
     }
 }
 
@@ -389,30 +1102,173 @@ void LipstickCompositor::surfaceLowered()
 
 void LipstickCompositor::windowSwapped()
 {
-    frameFinished(m_fullscreenSurface);
+    if (displayOff())
+        return;
+
+    if (m_displayAboutToBeOnTime) {
+        QMutexLocker locker(&m_frameTimingMutex);
+        if (m_lastSwapTime > m_displayAboutToBeOnTime) {
+            if (debug())
+                qDebug() << "First frame after display on swapped in"
+                         << (m_lastSwapTime - m_displayAboutToBeOnTime) / 1000. << "ms";
+            m_displayAboutToBeOnTime = 0;
+        }
+    }
+
+    int delay = frameCallbackDelay();
+    if (delay > 0)
+        m_frameCallbackTimer.start(delay);
+    else
+        sendFrameCallbacks();
+}
+
+void LipstickCompositor::sendFrameCallbacks()
+{
+    m_frameCallbackTimer.stop();
+
+    bool throttled = false;
+    foreach (LipstickCompositorWindow *window, m_windows) {
+        if (window->m_frameCallbackPending && window->frameCallbackInterval() != 0) {
+            throttled = true;
+            break;
+        }
+    }
+
+    if (!throttled) {
+        countFrameCallbacks(m_fullscreenSurface);
+        frameFinished(m_fullscreenSurface);
+        return;
+    }
+
+    // Some clients only draw for covers with a limited update rate; answer
+    // the others and come back when the next throttled callback is due
+    qint64 now = m_frameClock.elapsed();
+    qint64 nextDue = -1;
+    foreach (QWaylandSurface *surface, surfaces()) {
+        if (m_fullscreenSurface && surface != m_fullscreenSurface)
+            continue;
+
+        LipstickCompositorWindow *window = static_cast<LipstickCompositorWindow *>(surface->surfaceItem());
+        if (window) {
+            // A held or throttled client gets no callback it is not due,
+            // even without a pending commit; it would draw right away
+            int interval = window->frameCallbackInterval();
+            if (interval < 0)
+                continue;
+
+            if (interval > 0) {
+                if (!window->m_frameCallbackPending)
+                    continue;
+
+                qint64 due = window->m_lastFrameCallback + interval;
+                if (due > now) {
+                    if (nextDue < 0 || due < nextDue)
+                        nextDue = due;
+                    continue;
+                }
+            }
+
+            if (window->m_frameCallbackPending) {
+                window->m_frameCallbackPending = false;
+                window->m_coverRefreshPending = false;
+                window->m_lastFrameCallback = now;
+                ++window->m_statistics.frameCallbacks;
+            }
+        }
+
+        frameFinished(surface);
+    }
+
+    if (nextDue >= 0)
+        m_frameCallbackTimer.start(nextDue - now);
+}
+
+void LipstickCompositor::countFrameCallbacks(QWaylandSurface *surface)
+{
+    // A client that committed since the last frame is waiting for a callback
+    foreach (LipstickCompositorWindow *window, m_windows) {
+        if (window->m_frameCallbackPending && (!surface || window->surface() == surface)) {
+            window->m_frameCallbackPending = false;
+            window->m_coverRefreshPending = false;
+            window->m_lastFrameCallback = m_frameClock.elapsed();
+            ++window->m_statistics.frameCallbacks;
+        }
+    }
+}
+
+void LipstickCompositor::sampleWindowStatistics()
+{
+    qint64 elapsed = m_statisticsClock.restart();
+    if (elapsed <= 0)
+        return;
+
+    foreach (LipstickCompositorWindow *window, m_windows) {
+        const WindowStatistics &total = window->m_statistics;
+        const WindowStatistics &sampled = window->m_sampledStatistics;
+        WindowStatistics &rate = window->m_statisticsRate;
+
+        rate.commits = (total.commits - sampled.commits) * 1000 / elapsed;
+        rate.damagedPixels = (total.damagedPixels - sampled.damagedPixels) * 1000 / elapsed;
+        rate.frameCallbacks = (total.frameCallbacks - sampled.frameCallbacks) * 1000 / elapsed;
+        rate.inputEvents = (total.inputEvents - sampled.inputEvents) * 1000 / elapsed;
+
+        window->m_sampledStatistics = total;
+    }
+
+    for (int ii = 0; ii < m_windowModels.count(); ++ii)
+        m_windowModels.at(ii)->statisticsChanged();
+}
+
+void LipstickCompositor::subscribeWindowStatistics()
+{
+    if (m_statisticsSubscribers++ == 0 && !displayOff())
+        startWindowStatistics();
+}
+
+void LipstickCompositor::unsubscribeWindowStatistics()
+{
+    Q_ASSERT(m_statisticsSubscribers > 0);
+    if (--m_statisticsSubscribers == 0)
+        m_statisticsTimer.stop();
+}
+
+void LipstickCompositor::startWindowStatistics()
+{
+    // The counters kept running while no one was sampling them, start the
+    // first interval from their current values
+    foreach (LipstickCompositorWindow *window, m_windows)
+        window->m_sampledStatistics = window->m_statistics;
+
+    m_statisticsClock.start();
+    m_statisticsTimer.start();
 }
 
 void LipstickCompositor::windowDestroyed()
 {
+    m_windows.remove(static_cast<LipstickCompositorWindow *>(sender()));
+    m_pendingTouchWindows.remove(static_cast<LipstickCompositorWindow *>(sender()));
+    m_pendingSurfaceChanges.remove(static_cast<LipstickCompositorWindow *>(sender()));
     m_totalWindowCount--;
     emit ghostWindowCountChanged();
 }
 
-void LipstickCompositor::windowPropertyChanged(const QString &property)
+void LipstickCompositor::windowPropertyChanged(const QString &property, const QVariant &value)
 {
     QWaylandSurface *surface = qobject_cast<QWaylandSurface *>(sender());
 
     if (debug())
-        qDebug() << "Window properties changed:" << surface << surface->windowProperties();
+        qDebug() << "Window property changed:" << surface << property << value;
 
-    if (property == QLatin1String("MOUSE_REGION")) {
-        LipstickCompositorWindow *window = static_cast<LipstickCompositorWindow *>(surface->surfaceItem());
-        if (window)
-            window->refreshMouseRegion();
-    } else if (property == QLatin1String("GRABBED_KEYS")) {
-        LipstickCompositorWindow *window = static_cast<LipstickCompositorWindow *>(surface->surfaceItem());
-        if (window)
-            window->refreshGrabbedKeys();
+    LipstickCompositorWindow *window = static_cast<LipstickCompositorWindow *>(surface->surfaceItem());
+    if (!window)
+        return;
+
+    if (property == QLatin1String("WINID")) {
+        setWindowLink(window, value.toUInt());
+    } else {
+        // Only the last value set before the next frame is applied
+        window->m_pendingProperties.insert(property, value);
+        stageSurfaceChange(window);
     }
 }
 
@@ -435,7 +1291,7 @@ void LipstickCompositor::surfaceUnmapped(LipstickCompositorProcWindow *item)
     int id = item->windowId();
 
     int gc = ghostWindowCount();
-    m_mappedSurfaces.remove(item->windowId());
+    unregisterWindow(item);
 
     emit windowCountChanged();
     emit windowRemoved(item);
@@ -469,27 +1325,11 @@ bool LipstickCompositor::event(QEvent *e)
     // clear the m_updateRequest there (what happens after synchronizing,
     // needs to be updated)
     if (e->type() == QEvent::User)
-        update();
+        startFrame();
 
     return QQuickWindow::event(e);
 }
 
-QQmlComponent *LipstickCompositor::shaderEffectComponent()
-{
-    const char *qml_source =
-        "import QtQuick 2.0\n"
-        "ShaderEffect {\n"
-            "property QtObject window\n"
-            "property ShaderEffectSource source: ShaderEffectSource { sourceItem: window }\n"
-        "}";
-
-    if (!m_shaderEffect) {
-        m_shaderEffect = new QQmlComponent(qmlEngine(this));
-        m_shaderEffect->setData(qml_source, QUrl());
-    }
-    return m_shaderEffect;
-}
-
 void LipstickCompositor::setScreenOrientation(Qt::ScreenOrientation screenOrientation)
 {
     if (m_screenOrientation != screenOrientation) {
@@ -507,12 +1347,108 @@ void LipstickCompositor::setScreenOrientation(Qt::ScreenOrientation screenOrient
 void LipstickCompositor::reactOnDisplayStateChanges(MeeGo::QmDisplayState::DisplayState state)
 {
     if (state == MeeGo::QmDisplayState::On) {
+        if (m_displayAboutToBeOnTime && debug())
+            qDebug() << "Display on reported"
+                     << (m_frameClock.nsecsElapsed() / 1000 - m_displayAboutToBeOnTime) / 1000.
+                     << "ms after display about to be on";
+        setDisplayStateOff(false);
         emit displayOn();
     } else if (state == MeeGo::QmDisplayState::Off) {
+        setDisplayStateOff(true);
         emit displayOff();
     }
 }
 
+void LipstickCompositor::setUpdatesEnabled(bool enabled)
+{
+    if (m_updatesEnabled == enabled)
+        return;
+
+    if (!enabled) {
+        bool wasOff = displayOff();
+        m_updatesEnabled = false;
+        if (!wasOff)
+            suspendCompositing();
+        hide();
+    } else {
+        m_updatesEnabled = true;
+        if (!displayOff())
+            resumeCompositing();
+        // Exposing the window renders the one fresh frame
+        showFullScreen();
+    }
+}
+
+void LipstickCompositor::prepareDisplayOn()
+{
+    // MCE tells us the panel is about to be lit before QmDisplayState reports
+    // it on. Resume right away so that the first frame shown is a fresh one.
+    m_displayAboutToBeOnTime = m_frameClock.nsecsElapsed() / 1000;
+
+    if (debug())
+        qDebug() << "Display about to be on, rendering ahead";
+
+    // Let the clients redraw now rather than after the first composite
+    sendFrameCallbacks();
+
+    setDisplayStateOff(false);
+}
+
+void LipstickCompositor::setDisplayStateOff(bool off)
+{
+    if (m_displayStateOff == off)
+        return;
+
+    bool wasOff = displayOff();
+    m_displayStateOff = off;
+
+    if (!wasOff && displayOff())
+        suspendCompositing();
+    else if (wasOff && !displayOff())
+        resumeCompositing();
+}
+
+void LipstickCompositor::suspendCompositing()
+{
+    if (debug())
+        qDebug() << "Display off, suspending compositing";
+
+    // Drop any frame already scheduled, the request flag would otherwise
+    // block the first update after the display comes back on
+    m_frameTimer.stop();
+    m_frameCallbackTimer.stop();
+    m_statisticsTimer.stop();
+    m_updateRequestPosted.store(0);
+    m_damagedWhileDisplayOff = false;
+
+    // No frame is coming for the grabs still waiting for one
+    QMutexLocker locker(&m_frameGrabMutex);
+    QList<QPair<int, QRect> > requests = m_frameGrabRequests;
+    m_frameGrabRequests.clear();
+    m_frameGrabsPending.storeRelease(0);
+    locker.unlock();
+
+    for (int ii = 0; ii < requests.count(); ++ii)
+        emit frameGrabbed(requests.at(ii).first, QImage());
+}
+
+void LipstickCompositor::resumeCompositing()
+{
+    if (debug())
+        qDebug() << "Display on, resuming compositing" << (m_damagedWhileDisplayOff ? "with" : "without") << "pending damage";
+
+    m_damagedWhileDisplayOff = false;
+
+    if (m_statisticsSubscribers > 0)
+        startWindowStatistics();
+
+    // Composite exactly one fresh frame; its swap releases the frame
+    // callbacks held while the display was off. A hidden window gets its
+    // frame from being exposed.
+    if (isVisible())
+        maybePostUpdateRequest();
+}
+
 void LipstickCompositor::setScreenOrientationFromSensor()
 {
     QOrientationReading* reading = m_orientationSensor->reading();
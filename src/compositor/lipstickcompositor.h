@@ -22,11 +22,18 @@
 #include <QWaylandCompositor>
 #include <QWaylandSurfaceItem>
 #include <QPointer>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QSet>
 #include <qmdisplaystate.h>
 
 class WindowModel;
 class LipstickCompositorWindow;
 class LipstickCompositorProcWindow;
+class WindowProperty;
+class MemoryPressureMonitor;
+class FrameCaptureBuffer;
 class QOrientationSensor;
 
 class LIPSTICK_EXPORT LipstickCompositor : public QQuickWindow, public QWaylandCompositor,
@@ -82,9 +89,34 @@ public:
     Q_INVOKABLE void clearKeyboardFocus();
     Q_INVOKABLE void setDisplayOff();
 
+    void setUpdatesEnabled(bool enabled);
+
     LipstickCompositorProcWindow *mapProcWindow(const QString &title, const QString &category, const QRect &);
 
     QWaylandSurface *surfaceForId(int) const;
+    uint windowNotificationPreviewsDisabled(int) const;
+
+    QList<int> windowIdsForProcessId(qint64 processId) const;
+    QList<int> windowIdsForCategory(const QString &category) const;
+    // Windows whose process command line starts with the whitespace separated command
+    QList<int> windowIdsForCommand(const QString &command) const;
+    // Windows of processes started from the desktop file, e.g. "jolla-clock.desktop",
+    // matched on the commandApplication() of the process
+    QList<int> windowIdsForDesktopFile(const QString &desktopFileId) const;
+    // The application a command line runs: the executable, or for launchers and
+    // runtimes like "sailfish-qml jolla-clock" or "invoker --type=silica-qt5
+    // /usr/bin/jolla-calendar" their first argument after the options. Empty
+    // if a runtime has no such argument.
+    static QString commandApplication(const QStringList &arguments);
+
+    // Reads back the region, in logical coordinates, of the next rendered frame on
+    // the render thread and emits frameGrabbed() with the returned id; returns -1
+    // if no frame is rendered
+    int requestFrameGrab(const QRect &region);
+    // Captures every rendered frame into the buffer until unset with 0. Takes
+    // ownership; a buffer replaced or unset is deleted on the render thread,
+    // which holds its GL resources.
+    void setFrameCapture(FrameCaptureBuffer *buffer);
 
 signals:
     void windowAdded(QObject *window);
@@ -108,6 +140,11 @@ signals:
     void displayOff();
     void displayAboutToBeOn();
 
+    // Emitted on the render thread; the image holds the bottom-up GL_RGBA rows
+    // of the region as read, see requestFrameGrab(). Emitted with a null image
+    // on the GUI thread if compositing is suspended before the frame is rendered.
+    void frameGrabbed(int request, const QImage &image);
+
 protected:
     virtual bool event(QEvent *);
     virtual void surfaceAboutToBeDestroyed(QWaylandSurface *surface);
@@ -115,6 +152,18 @@ protected:
 private slots:
     void clearUpdateRequest();
     void maybePostUpdateRequest();
+    void startFrame();
+    void flushTouchEvents();
+    void applySurfaceChanges();
+    void sendFrameCallbacks();
+    void frameSyncStarted();
+    void frameRenderedOnRenderThread();
+    void frameSwappedOnRenderThread();
+    void grabFrameOnRenderThread();
+    void prepareDisplayOn();
+    void releaseWindowBuffers();
+    void reapBackgroundApplications();
+    void sampleWindowStatistics();
     void surfaceMapped();
     void surfaceUnmapped();
     void surfaceSizeChanged();
@@ -124,7 +173,7 @@ private slots:
     void surfaceDamaged(const QRect &);
     void windowSwapped();
     void windowDestroyed();
-    void windowPropertyChanged(const QString &);
+    void windowPropertyChanged(const QString &, const QVariant &);
     void openUrl(const QUrl &);
     void reactOnDisplayStateChanges(MeeGo::QmDisplayState::DisplayState state);
     void homeApplicationAboutToDestroy();
@@ -137,37 +186,115 @@ private:
     friend class WindowModel;
     friend class WindowPixmapItem;
     friend class WindowProperty;
+#ifdef UNIT_TEST
+    friend class CompositorTestHarness;
+#endif
 
     void surfaceUnmapped(LipstickCompositorProcWindow *item);
 
-    int windowIdForLink(QWaylandSurface *, uint) const;
+    void registerWindow(LipstickCompositorWindow *);
+    void unregisterWindow(LipstickCompositorWindow *);
+    void setWindowLink(LipstickCompositorWindow *, uint);
+
+    int acquireWindowLink(WindowProperty *);
+    void releaseWindowLink(WindowProperty *);
 
     void surfaceUnmapped(QWaylandSurface *);
 
     void windowAdded(int);
     void windowRemoved(int);
 
-    QQmlComponent *shaderEffectComponent();
+    bool displayOff() const { return m_displayStateOff || !m_updatesEnabled; }
+    void setDisplayStateOff(bool);
+    void suspendCompositing();
+    void resumeCompositing();
+
+    void countFrameCallbacks(QWaylandSurface *);
+    void subscribeWindowStatistics();
+    void unsubscribeWindowStatistics();
+    void startWindowStatistics();
+    void setWindowViewed(LipstickCompositorWindow *);
+    void setWindowDowngraded(LipstickCompositorWindow *, bool);
+    void checkWindowBufferBudget();
+    void trimWindowBuffers(qint64 target);
+    static bool viewedBefore(LipstickCompositorWindow *, LipstickCompositorWindow *);
+
+    void loadReaperSettings();
+    void loadTouchSettings();
+
+    void scheduleTouchFlush(LipstickCompositorWindow *);
+    void stageSurfaceChange(LipstickCompositorWindow *);
+
+    qint64 nextFrameDeadline(qint64 now);
+    int frameDelay();
+    int frameCallbackDelay();
+    int presentationDelay();
 
     static LipstickCompositor *m_instance;
 
     int m_totalWindowCount;
     QHash<int, LipstickCompositorWindow *> m_mappedSurfaces;
-
+    QMultiHash<qint64, int> m_windowIdsByProcessId;
+    QMultiHash<QString, int> m_windowIdsByCategory;
+    QMultiHash<QString, int> m_windowIdsByCommand;
+    QMultiHash<QString, int> m_windowIdsByDesktopFile;
+    QHash<QPair<qint64, uint>, int> m_windowIdsByLink;
+    QMultiHash<QPair<qint64, uint>, WindowProperty *> m_pendingWindowLinks;
+    QMultiHash<int, WindowProperty *> m_resolvedWindowLinks;
+    QSet<LipstickCompositorWindow *> m_windows;
+    MemoryPressureMonitor *m_memoryPressureMonitor;
+    qint64 m_windowBufferBudget;
+    qint64 m_reaperThreshold;
+    int m_reaperKillTimeout;
+    QStringList m_reaperProtected;
+    bool m_touchCoalescing;
+    bool m_touchPrediction;
+    QHash<QString, bool> m_touchCoalescingByCategory;
+    QHash<QString, bool> m_touchPredictionByCategory;
+    QSet<LipstickCompositorWindow *> m_pendingTouchWindows;
+    QSet<LipstickCompositorWindow *> m_pendingSurfaceChanges;
+    QTimer m_touchFlushTimer;
+    QTimer m_statisticsTimer;
+    QElapsedTimer m_statisticsClock;
+    int m_statisticsSubscribers;
+
+    // Window ids are never reused and only ever increase; WindowModel keeps
+    // its rows sorted by id, which is the order windows were created in
     int m_nextWindowId;
     QList<WindowModel *> m_windowModels;
 
     bool m_homeActive;
 
-    QQmlComponent *m_shaderEffect;
     QWaylandSurface *m_fullscreenSurface;
     bool m_directRenderingActive;
     int m_topmostWindowId;
     Qt::ScreenOrientation m_screenOrientation;
     MeeGo::QmDisplayState *m_displayState;
+    bool m_displayStateOff;
+    bool m_updatesEnabled;
+    bool m_damagedWhileDisplayOff;
+    qint64 m_displayAboutToBeOnTime;
     QAtomicInt m_updateRequestPosted;
+    QTimer m_frameTimer;
+    QTimer m_frameCallbackTimer;
+    QElapsedTimer m_frameClock;
+    QMutex m_frameTimingMutex;
+    qint64 m_syncStartTime;
+    qint64 m_lastSwapTime;
+    qint64 m_frameInterval;
+    qint64 m_renderTime;
+    qint64 m_frameMargin;
+    qint64 m_frameCallbackBudget;
+    QMutex m_frameGrabMutex;
+    QList<QPair<int, QRect> > m_frameGrabRequests;
+    QAtomicInt m_frameGrabsPending;
+    int m_nextFrameGrab;
+    FrameCaptureBuffer *m_frameCapture;
+    QList<FrameCaptureBuffer *> m_retiredFrameCaptures;
+    QAtomicInt m_frameCaptureActive;
     QOrientationSensor* m_orientationSensor;
     QPointer<QMimeData> m_retainedSelection;
+    int m_clipboardFormatLimit;
 };
 
 #endif // LIPSTICKCOMPOSITOR_H
@@ -27,7 +27,8 @@ LipstickCompositorProcWindow *LipstickCompositor::mapProcWindow(const QString &t
     item->setTitle(title);
     QObject::connect(item, SIGNAL(destroyed(QObject*)), this, SLOT(windowDestroyed()));
     m_totalWindowCount++;
-    m_mappedSurfaces.insert(id, item);
+    m_windows.insert(item);
+    registerWindow(item);
 
     item->setPosition(g.topLeft());
     item->setTouchEventsEnabled(true);
@@ -43,7 +44,7 @@ LipstickCompositorProcWindow *LipstickCompositor::mapProcWindow(const QString &t
 }
 
 LipstickCompositorProcWindow::LipstickCompositorProcWindow(int windowId, const QString &c, QQuickItem *parent)
-: LipstickCompositorWindow(windowId, c, 0, parent)
+: LipstickCompositorWindow(windowId, c, 0, parent), m_layerRef(0)
 {
 }
 
@@ -61,6 +62,42 @@ bool LipstickCompositorProcWindow::isInProcess() const
     return true;
 }
 
+/*
+    An in-process window has no client buffer of its own. While it is shown
+    through WindowPixmapItems it is rendered into an item layer, which is
+    only redrawn when the window content changes, and the covers sample the
+    layer texture directly.
+*/
+bool LipstickCompositorProcWindow::isTextureProvider() const
+{
+    return QQuickItem::isTextureProvider();
+}
+
+QSGTextureProvider *LipstickCompositorProcWindow::textureProvider() const
+{
+    return QQuickItem::textureProvider();
+}
+
+void LipstickCompositorProcWindow::layerAddref()
+{
+    if (m_layerRef++ == 0)
+        setLayerEnabled(true);
+}
+
+void LipstickCompositorProcWindow::layerRelease()
+{
+    Q_ASSERT(m_layerRef);
+    if (--m_layerRef == 0)
+        setLayerEnabled(false);
+}
+
+void LipstickCompositorProcWindow::setLayerEnabled(bool enabled)
+{
+    QObject *layer = property("layer").value<QObject *>();
+    if (layer)
+        layer->setProperty("enabled", enabled);
+}
+
 QString LipstickCompositorProcWindow::title() const
 {
     return m_title;
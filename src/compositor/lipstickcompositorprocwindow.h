@@ -25,15 +25,22 @@ public:
     void hide();
 
     virtual bool isInProcess() const;
-    virtual bool isTextureProvider() const { return false; }
+    virtual bool isTextureProvider() const;
+    virtual QSGTextureProvider *textureProvider() const;
 
     virtual QString title() const;
     void setTitle(const QString &);
 private:
     friend class LipstickCompositor;
+    friend class WindowPixmapItem;
     LipstickCompositorProcWindow(int windowId, const QString &, QQuickItem *parent = 0);
 
+    void layerAddref();
+    void layerRelease();
+    void setLayerEnabled(bool);
+
     QString m_title;
+    int m_layerRef;
 };
 
 #endif // LIPSTICKCOMPOSITORPROCWINDOW_H
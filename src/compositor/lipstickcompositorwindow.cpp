@@ -17,26 +17,55 @@
 #include <QWaylandCompositor>
 #include <QWaylandInputDevice>
 #include <QTimer>
+#include <QFile>
 #include <sys/types.h>
 #include <signal.h>
 #include "lipstickcompositor.h"
 #include "lipstickcompositorwindow.h"
+#include "windowpixmapitem.h"
+
+// Start time of the process in clock ticks after boot, which tells a reused
+// pid apart from the process that had it before; 0 if there is no such process
+static quint64 processStartTime(qint64 pid)
+{
+    QFile file(QString("/proc/%1/stat").arg(pid));
+    if (pid <= 0 || !file.open(QIODevice::ReadOnly))
+        return 0;
+
+    // The command name may contain spaces and parentheses, the fields after it
+    // start with the state; the start time is the 22nd field of the line
+    QByteArray stat = file.readAll();
+    QList<QByteArray> fields = stat.mid(stat.lastIndexOf(')') + 2).split(' ');
+    return fields.count() > 19 ? fields.at(19).toULongLong() : 0;
+}
 
 LipstickCompositorWindow::LipstickCompositorWindow(int windowId, const QString &category,
                                                    QWaylandSurface *surface, QQuickItem *parent)
-: QWaylandSurfaceItem(surface, parent), m_windowId(windowId), m_category(category), m_ref(0),
-  m_delayRemove(false), m_windowClosed(false), m_removePosted(false), m_mouseRegionValid(false)
+: QWaylandSurfaceItem(surface, parent), m_windowId(windowId),
+  m_processId(surface ? surface->processId() : 0), m_terminatedStartTime(0), m_winId(0),
+  m_notificationPreviewsDisabled(0), m_category(category), m_ref(0),
+  m_delayRemove(false), m_windowClosed(false), m_removePosted(false), m_mouseRegionValid(false),
+  m_downgraded(false), m_sizePending(false), m_titlePending(false), m_lastViewed(0), m_frameCallbackPending(false),
+  m_coverRefreshPending(false), m_lastFrameCallback(0),
+  m_coalesceTouch(false), m_predictTouch(false), m_pendingTouchEvent(0)
 {
     setFlags(QQuickItem::ItemIsFocusScope | flags());
-    refreshMouseRegion();
+    refreshWindowProperties();
 
     // Handle ungrab situations
     connect(this, SIGNAL(visibleChanged()), SLOT(handleTouchCancel()));
     connect(this, SIGNAL(enabledChanged()), SLOT(handleTouchCancel()));
     connect(this, SIGNAL(touchEventsEnabledChanged()), SLOT(handleTouchCancel()));
 
-    connect(this, SIGNAL(surfaceChanged()), SLOT(connectSurfaceSignals()));
-    connectSurfaceSignals();
+    // Title changes of the surface are staged and delivered by the compositor
+    connect(this, SIGNAL(surfaceChanged()), SIGNAL(titleChanged()));
+}
+
+LipstickCompositorWindow::~LipstickCompositorWindow()
+{
+    if (!m_grabbedKeys.isEmpty())
+        InputRouter::instance()->setGrabbedKeys(this, QList<int>());
+    delete m_pendingTouchEvent;
 }
 
 QVariant LipstickCompositorWindow::userData() const
@@ -60,8 +89,8 @@ int LipstickCompositorWindow::windowId() const
 
 qint64 LipstickCompositorWindow::processId() const
 {
-    if (surface()) return surface()->processId();
-    else return 0;
+    // Cached, as the client may already be gone by the time the window is removed
+    return m_processId;
 }
 
 bool LipstickCompositorWindow::delayRemove() const
@@ -92,6 +121,13 @@ QString LipstickCompositorWindow::title() const
     return QString();
 }
 
+qint64 LipstickCompositorWindow::bufferBytes() const
+{
+    // Both the client buffer and the texture made from it are 32 bits per pixel
+    QSize s = surface() ? surface()->size() : size().toSize();
+    return qint64(s.width()) * s.height() * 4;
+}
+
 void LipstickCompositorWindow::imageAddref()
 {
     ++m_ref;
@@ -125,59 +161,139 @@ QRect LipstickCompositorWindow::mouseRegionBounds() const
         return QRect(0, 0, width(), height());
 }
 
-void LipstickCompositorWindow::refreshMouseRegion()
+void LipstickCompositorWindow::refreshWindowProperties()
 {
+    // Take the one full copy of the property map up front; from here on the
+    // snapshot is kept current by setWindowProperty()
     QWaylandSurface *s = surface();
-    if (s) {
-        QVariantMap properties = s->windowProperties();
-        if (properties.contains(QLatin1String("MOUSE_REGION"))) {
-            m_mouseRegion = s->windowProperties().value("MOUSE_REGION").value<QRegion>();
-            m_mouseRegionValid = true;
-            if (LipstickCompositor::instance()->debug())
-                qDebug() << "Window" << windowId() << "mouse region set:" << m_mouseRegion;
-        } else {
-            m_mouseRegionValid = false;
-            if (LipstickCompositor::instance()->debug())
-                qDebug() << "Window" << windowId() << "mouse region cleared";
-        }
+    if (!s)
+        return;
 
-        emit mouseRegionBoundsChanged();
+    const QVariantMap properties = s->windowProperties();
+    m_winId = properties.value(QLatin1String("WINID"), uint(0)).toUInt();
+    setMouseRegion(properties.value(QLatin1String("MOUSE_REGION")));
+    setGrabbedKeys(properties.value(QLatin1String("GRABBED_KEYS")));
+    setNotificationPreviewsDisabled(properties.value(QLatin1String("NOTIFICATION_PREVIEWS_DISABLED")));
+}
+
+void LipstickCompositorWindow::setWindowProperty(const QString &name, const QVariant &value)
+{
+    if (name == QLatin1String("MOUSE_REGION"))
+        setMouseRegion(value);
+    else if (name == QLatin1String("GRABBED_KEYS"))
+        setGrabbedKeys(value);
+    else if (name == QLatin1String("NOTIFICATION_PREVIEWS_DISABLED"))
+        setNotificationPreviewsDisabled(value);
+}
+
+void LipstickCompositorWindow::applyPendingChanges()
+{
+    if (m_sizePending) {
+        m_sizePending = false;
+        if (QWaylandSurface *s = surface())
+            setSize(s->size());
     }
+
+    const QVariantMap properties = m_pendingProperties;
+    m_pendingProperties.clear();
+    for (QVariantMap::const_iterator it = properties.constBegin(); it != properties.constEnd(); ++it)
+        setWindowProperty(it.key(), it.value());
 }
 
-void LipstickCompositorWindow::refreshGrabbedKeys()
+/*!
+    Returns the minimum time in milliseconds between two frame callbacks
+    for the client, 0 for no limit or -1 if callbacks are held. Only the
+    covers limit the rate and only while the home screen is active.
+*/
+int LipstickCompositorWindow::frameCallbackInterval() const
 {
-    QWaylandSurface *s = surface();
-    if (s) {
-        const QStringList grabbedKeys = s->windowProperties().value(
-                    QLatin1String("GRABBED_KEYS")).value<QStringList>();
-
-        if (m_grabbedKeys.isEmpty() && !grabbedKeys.isEmpty()) {
-            qApp->installEventFilter(this);
-        } else if (!m_grabbedKeys.isEmpty() && grabbedKeys.isEmpty()) {
-            qApp->removeEventFilter(this);
+    if (m_covers.isEmpty() || !LipstickCompositor::instance()->homeActive())
+        return 0;
+
+    int interval = -1;
+    foreach (WindowPixmapItem *cover, m_covers) {
+        int coverInterval = -1;
+        switch (cover->updatePolicy()) {
+        case WindowPixmapItem::Live:
+            coverInterval = 0;
+            break;
+        case WindowPixmapItem::Throttled:
+            coverInterval = cover->updateRate() > 0 ? 1000 / cover->updateRate() : 0;
+            break;
+        case WindowPixmapItem::OnActivate:
+            coverInterval = m_coverRefreshPending ? 0 : -1;
+            break;
+        case WindowPixmapItem::Frozen:
+            break;
         }
 
-        m_grabbedKeys.clear();
-        foreach (const QString &key, grabbedKeys)
-            m_grabbedKeys.append(key.toInt());
+        if (coverInterval == 0)
+            return 0;
+        if (interval < 0 || (coverInterval >= 0 && coverInterval < interval))
+            interval = coverInterval;
+    }
+
+    return interval;
+}
 
+void LipstickCompositorWindow::setMouseRegion(const QVariant &value)
+{
+    if (value.isValid()) {
+        m_mouseRegion = value.value<QRegion>();
+        m_mouseRegionValid = true;
+        if (LipstickCompositor::instance()->debug())
+            qDebug() << "Window" << windowId() << "mouse region set:" << m_mouseRegion;
+    } else if (m_mouseRegionValid) {
+        m_mouseRegion = QRegion();
+        m_mouseRegionValid = false;
         if (LipstickCompositor::instance()->debug())
-            qDebug() << "Window" << windowId() << "grabbed keys changed:" << grabbedKeys;
+            qDebug() << "Window" << windowId() << "mouse region cleared";
+    } else {
+        return;
     }
+
+    emit mouseRegionBoundsChanged();
 }
 
-bool LipstickCompositorWindow::eventFilter(QObject *, QEvent *event)
+void LipstickCompositorWindow::setGrabbedKeys(const QVariant &value)
 {
-    if (event->type() == QEvent::KeyPress || event->type() == QEvent::KeyRelease) {
-        QKeyEvent *ke = static_cast<QKeyEvent *>(event);
-        QWaylandSurface *m_surface = surface();
-        if (m_surface && m_grabbedKeys.contains(ke->key())) {
-            QWaylandInputDevice *inputDevice = m_surface->compositor()->defaultInputDevice();
-            inputDevice->sendFullKeyEvent(m_surface, ke);
+    const QStringList grabbedKeys = value.value<QStringList>();
 
-            return true;
-        }
+    QList<int> keys;
+    foreach (const QString &key, grabbedKeys)
+        keys.append(key.toInt());
+
+    if (keys == m_grabbedKeys)
+        return;
+
+    m_grabbedKeys = keys;
+    InputRouter::instance()->setGrabbedKeys(this, keys);
+
+    if (LipstickCompositor::instance()->debug())
+        qDebug() << "Window" << windowId() << "grabbed keys changed:" << grabbedKeys;
+
+    emit grabbedKeysChanged();
+}
+
+void LipstickCompositorWindow::setNotificationPreviewsDisabled(const QVariant &value)
+{
+    uint mode = value.toUInt();
+    if (m_notificationPreviewsDisabled == mode)
+        return;
+
+    m_notificationPreviewsDisabled = mode;
+    emit notificationPreviewsDisabledChanged();
+}
+
+bool LipstickCompositorWindow::handleKeyEvent(QKeyEvent *event)
+{
+    QWaylandSurface *m_surface = surface();
+    if (m_surface) {
+        QWaylandInputDevice *inputDevice = m_surface->compositor()->defaultInputDevice();
+        inputDevice->sendFullKeyEvent(m_surface, event);
+        ++m_statistics.inputEvents;
+
+        return true;
     }
     return false;
 }
@@ -205,6 +321,7 @@ void LipstickCompositorWindow::mousePressEvent(QMouseEvent *event)
         if (inputDevice->mouseFocus() != m_surface)
             inputDevice->setMouseFocus(m_surface, event->pos(), event->globalPos());
         inputDevice->sendMousePressEvent(event->button(), event->pos(), event->globalPos());
+        ++m_statistics.inputEvents;
     } else {
         event->ignore();
     }
@@ -216,6 +333,7 @@ void LipstickCompositorWindow::mouseMoveEvent(QMouseEvent *event)
     if (m_surface){
         QWaylandInputDevice *inputDevice = m_surface->compositor()->defaultInputDevice();
         inputDevice->sendMouseMoveEvent(m_surface, event->pos(), event->globalPos());
+        ++m_statistics.inputEvents;
     } else {
         event->ignore();
     }
@@ -227,6 +345,7 @@ void LipstickCompositorWindow::mouseReleaseEvent(QMouseEvent *event)
     if (m_surface){
         QWaylandInputDevice *inputDevice = m_surface->compositor()->defaultInputDevice();
         inputDevice->sendMouseReleaseEvent(event->button(), event->pos(), event->globalPos());
+        ++m_statistics.inputEvents;
     } else {
         event->ignore();
     }
@@ -238,6 +357,7 @@ void LipstickCompositorWindow::wheelEvent(QWheelEvent *event)
     if (m_surface) {
         QWaylandInputDevice *inputDevice = m_surface->compositor()->defaultInputDevice();
         inputDevice->sendMouseWheelEvent(event->orientation(), event->delta());
+        ++m_statistics.inputEvents;
     } else {
         event->ignore();
     }
@@ -256,20 +376,127 @@ void LipstickCompositorWindow::touchEvent(QTouchEvent *event)
             return;
         }
 
-        QWaylandInputDevice *inputDevice = m_surface->compositor()->defaultInputDevice();
         event->accept();
-        if (inputDevice->mouseFocus() != m_surface) {
-            QPoint pointPos;
-            if (!points.isEmpty())
-                pointPos = points.at(0).pos().toPoint();
-            inputDevice->setMouseFocus(m_surface, pointPos, pointPos);
+
+        // Motion is sent once per frame at most; presses and releases go out
+        // right away, after any motion still waiting so that order is kept
+        if (m_coalesceTouch && !(event->touchPointStates() & (Qt::TouchPointPressed | Qt::TouchPointReleased))) {
+            coalesceTouchEvent(event);
+        } else {
+            LipstickCompositor::instance()->flushTouchEvents();
+            sendTouchEvent(event);
         }
-        inputDevice->sendFullTouchEvent(event);
     } else {
         event->ignore();
     }
 }
 
+void LipstickCompositorWindow::sendTouchEvent(QTouchEvent *event)
+{
+    QWaylandSurface *m_surface = surface();
+    if (!m_surface)
+        return;
+
+    QList<QTouchEvent::TouchPoint> points = event->touchPoints();
+
+    QWaylandInputDevice *inputDevice = m_surface->compositor()->defaultInputDevice();
+    if (inputDevice->mouseFocus() != m_surface) {
+        QPoint pointPos;
+        if (!points.isEmpty())
+            pointPos = points.at(0).pos().toPoint();
+        inputDevice->setMouseFocus(m_surface, pointPos, pointPos);
+    }
+    inputDevice->sendFullTouchEvent(event);
+    ++m_statistics.inputEvents;
+
+    if (m_predictTouch) {
+        qint64 now = LipstickCompositor::instance()->m_frameClock.elapsed();
+        foreach (const QTouchEvent::TouchPoint &point, points) {
+            if (point.state() == Qt::TouchPointReleased)
+                m_touchHistory.remove(point.id());
+            else if (point.state() == Qt::TouchPointPressed)
+                m_touchHistory.insert(point.id(), qMakePair(point.pos(), now));
+        }
+    }
+}
+
+void LipstickCompositorWindow::coalesceTouchEvent(QTouchEvent *event)
+{
+    QList<QTouchEvent::TouchPoint> points = event->touchPoints();
+
+    if (m_pendingTouchEvent) {
+        // Every event carries all current points, so the newest one replaces the
+        // pending one; a point that moved in the replaced event still has to be
+        // reported as moved
+        QList<QTouchEvent::TouchPoint> pendingPoints = m_pendingTouchEvent->touchPoints();
+        Qt::TouchPointStates states = 0;
+        for (int ii = 0; ii < points.count(); ++ii) {
+            if (points.at(ii).state() == Qt::TouchPointStationary) {
+                foreach (const QTouchEvent::TouchPoint &pending, pendingPoints) {
+                    if (pending.id() == points.at(ii).id() && pending.state() == Qt::TouchPointMoved)
+                        points[ii].setState(Qt::TouchPointMoved);
+                }
+            }
+            states |= points.at(ii).state();
+        }
+
+        delete m_pendingTouchEvent;
+        m_pendingTouchEvent = new QTouchEvent(*event);
+        m_pendingTouchEvent->setTouchPoints(points);
+        m_pendingTouchEvent->setTouchPointStates(states);
+    } else {
+        m_pendingTouchEvent = new QTouchEvent(*event);
+        LipstickCompositor::instance()->scheduleTouchFlush(this);
+    }
+}
+
+void LipstickCompositorWindow::flushTouchEvent()
+{
+    if (!m_pendingTouchEvent)
+        return;
+
+    QTouchEvent *event = m_pendingTouchEvent;
+    m_pendingTouchEvent = 0;
+
+    if (m_predictTouch)
+        predictTouchPoints(event);
+
+    sendTouchEvent(event);
+    delete event;
+}
+
+void LipstickCompositorWindow::predictTouchPoints(QTouchEvent *event)
+{
+    // Extrapolate each moving point linearly to the time the frame showing the
+    // client's response is presented, at most one frame ahead
+    LipstickCompositor *c = LipstickCompositor::instance();
+    qint64 now = c->m_frameClock.elapsed();
+    qint64 ahead = c->presentationDelay();
+
+    QList<QTouchEvent::TouchPoint> points = event->touchPoints();
+    for (int ii = 0; ii < points.count(); ++ii) {
+        QTouchEvent::TouchPoint &point = points[ii];
+        if (point.state() != Qt::TouchPointMoved)
+            continue;
+
+        QPointF position = point.pos();
+        if (m_touchHistory.contains(point.id())) {
+            const QPair<QPointF, qint64> &last = m_touchHistory.value(point.id());
+            qint64 elapsed = now - last.second;
+            if (elapsed > 0 && elapsed < 100) {
+                QPointF delta = (position - last.first) * (qreal(ahead) / elapsed);
+                point.setPos(point.pos() + delta);
+                point.setScenePos(point.scenePos() + delta);
+                point.setScreenPos(point.screenPos() + delta);
+            }
+        }
+
+        m_touchHistory.insert(point.id(), qMakePair(position, now));
+    }
+
+    event->setTouchPoints(points);
+}
+
 void LipstickCompositorWindow::handleTouchCancel()
 {
     QWaylandSurface *m_surface = surface();
@@ -278,6 +505,9 @@ void LipstickCompositorWindow::handleTouchCancel()
     QWaylandInputDevice *inputDevice = m_surface->compositor()->defaultInputDevice();
     if (inputDevice->mouseFocus() == m_surface &&
             (!isVisible() || !isEnabled() || !touchEventsEnabled())) {
+        delete m_pendingTouchEvent;
+        m_pendingTouchEvent = 0;
+        m_touchHistory.clear();
         inputDevice->sendTouchCancelEvent();
         inputDevice->setMouseFocus(0, QPointF());
     }
@@ -285,6 +515,10 @@ void LipstickCompositorWindow::handleTouchCancel()
 
 void LipstickCompositorWindow::terminateProcess(int killTimeout)
 {
+    m_terminatedStartTime = processStartTime(processId());
+    if (!m_terminatedStartTime)
+        return;
+
     kill(processId(), SIGTERM);
 
     QTimer::singleShot(killTimeout, this, SLOT(killProcess()));
@@ -292,17 +526,9 @@ void LipstickCompositorWindow::terminateProcess(int killTimeout)
 
 void LipstickCompositorWindow::killProcess()
 {
-    kill(processId(), SIGKILL);
-}
-
-void LipstickCompositorWindow::connectSurfaceSignals()
-{
-    foreach (const QMetaObject::Connection &connection, m_surfaceConnections) {
-        disconnect(connection);
-    }
+    // The window may outlive its process, and the pid be reused by then
+    if (processStartTime(processId()) != m_terminatedStartTime)
+        return;
 
-    m_surfaceConnections.clear();
-    if (surface()) {
-        m_surfaceConnections << connect(surface(), SIGNAL(titleChanged()), SIGNAL(titleChanged()));
-    }
+    kill(processId(), SIGKILL);
 }
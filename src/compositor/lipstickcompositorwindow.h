@@ -18,8 +18,21 @@
 
 #include <QWaylandSurfaceItem>
 #include "lipstickglobal.h"
+#include "inputrouter.h"
 
-class LIPSTICK_EXPORT LipstickCompositorWindow : public QWaylandSurfaceItem
+struct WindowStatistics
+{
+    WindowStatistics() : commits(0), damagedPixels(0), frameCallbacks(0), inputEvents(0) {}
+
+    quint64 commits;
+    quint64 damagedPixels;
+    quint64 frameCallbacks;
+    quint64 inputEvents;
+};
+
+class WindowPixmapItem;
+
+class LIPSTICK_EXPORT LipstickCompositorWindow : public QWaylandSurfaceItem, public InputRouter::KeyHandler
 {
     Q_OBJECT
 
@@ -37,6 +50,7 @@ class LIPSTICK_EXPORT LipstickCompositorWindow : public QWaylandSurfaceItem
 
 public:
     LipstickCompositorWindow(int windowId, const QString &, QWaylandSurface *surface, QQuickItem *parent = 0);
+    ~LipstickCompositorWindow();
 
     QVariant userData() const;
     void setUserData(QVariant);
@@ -52,8 +66,15 @@ public:
     virtual bool isInProcess() const;
 
     QRect mouseRegionBounds() const;
+    QList<int> grabbedKeys() const { return m_grabbedKeys; }
+    uint notificationPreviewsDisabled() const { return m_notificationPreviewsDisabled; }
+    uint winId() const { return m_winId; }
+
+    qint64 bufferBytes() const;
+    // Per second rates, sampled by the compositor once a second
+    WindowStatistics statisticsRate() const { return m_statisticsRate; }
 
-    bool eventFilter(QObject *object, QEvent *event);
+    bool handleKeyEvent(QKeyEvent *event);
 
     Q_INVOKABLE void terminateProcess(int killTimeout);
 
@@ -70,11 +91,14 @@ signals:
     void titleChanged();
     void delayRemoveChanged();
     void mouseRegionBoundsChanged();
+    void grabbedKeysChanged();
+    void notificationPreviewsDisabledChanged();
+    void winIdChanged();
+    void downgradedChanged();
 
 private slots:
     void handleTouchCancel();
     void killProcess();
-    void connectSurfaceSignals();
 
 private:
     friend class LipstickCompositor;
@@ -84,20 +108,50 @@ private:
 
     bool canRemove() const;
     void tryRemove();
-    void refreshMouseRegion();
-    void refreshGrabbedKeys();
+    void sendTouchEvent(QTouchEvent *);
+    void coalesceTouchEvent(QTouchEvent *);
+    void flushTouchEvent();
+    void predictTouchPoints(QTouchEvent *);
+    int frameCallbackInterval() const;
+
+    void refreshWindowProperties();
+    void setWindowProperty(const QString &, const QVariant &);
+    void applyPendingChanges();
+    void setMouseRegion(const QVariant &);
+    void setGrabbedKeys(const QVariant &);
+    void setNotificationPreviewsDisabled(const QVariant &);
 
     int m_windowId;
+    qint64 m_processId;
+    quint64 m_terminatedStartTime;
+    uint m_winId;
+    QStringList m_arguments;
+    uint m_notificationPreviewsDisabled;
     QString m_category;
     int m_ref;
     bool m_delayRemove:1;
     bool m_windowClosed:1;
     bool m_removePosted:1;
     bool m_mouseRegionValid:1;
+    bool m_downgraded:1;
+    bool m_sizePending:1;
+    bool m_titlePending:1;
+    qint64 m_lastViewed;
+    bool m_frameCallbackPending;
+    bool m_coverRefreshPending;
+    qint64 m_lastFrameCallback;
+    QList<WindowPixmapItem *> m_covers;
+    bool m_coalesceTouch;
+    bool m_predictTouch;
+    QTouchEvent *m_pendingTouchEvent;
+    QHash<int, QPair<QPointF, qint64> > m_touchHistory;
+    WindowStatistics m_statistics;
+    WindowStatistics m_sampledStatistics;
+    WindowStatistics m_statisticsRate;
     QVariant m_data;
     QRegion m_mouseRegion;
     QList<int> m_grabbedKeys;
-    QList<QMetaObject::Connection> m_surfaceConnections;
+    QVariantMap m_pendingProperties;
 };
 
 #endif // LIPSTICKCOMPOSITORWINDOW_H
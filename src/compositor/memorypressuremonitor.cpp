@@ -0,0 +1,67 @@
+/***************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd.
+** Contact: Aaron Kennedy <aaron.kennedy@jollamobile.com>
+**
+** This file is part of lipstick.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include <QSocketNotifier>
+#include <QDebug>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include "memorypressuremonitor.h"
+
+MemoryPressureMonitor::MemoryPressureMonitor(QObject *parent)
+: QObject(parent), m_fd(-1), m_notifier(0)
+{
+    m_fd = open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0)
+        return;
+
+    // Wake up when some task has been stalled on memory for 300ms within two
+    // seconds, the default can be overridden with a trigger of the same format.
+    // Without CAP_SYS_RESOURCE the kernel only accepts windows that are a
+    // multiple of two seconds, and older kernels no unprivileged triggers at all.
+    QByteArray trigger = qgetenv("LIPSTICK_MEMORY_PRESSURE_TRIGGER");
+    if (trigger.isEmpty())
+        trigger = "some 300000 2000000";
+
+    if (write(m_fd, trigger.constData(), trigger.length() + 1) < 0) {
+        qWarning() << "MemoryPressureMonitor: Could not set memory pressure trigger" << trigger << strerror(errno)
+                   << "- window buffers are only trimmed and applications only reaped when windows are mapped";
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+
+    // The kernel signals a trigger as POLLPRI, which QSocketNotifier reports as an exception
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Exception, this);
+    connect(m_notifier, SIGNAL(activated(int)), this, SLOT(pressureEvent()));
+}
+
+MemoryPressureMonitor::~MemoryPressureMonitor()
+{
+    delete m_notifier;
+    if (m_fd >= 0)
+        close(m_fd);
+}
+
+bool MemoryPressureMonitor::isAvailable() const
+{
+    return m_notifier != 0;
+}
+
+void MemoryPressureMonitor::pressureEvent()
+{
+    emit memoryPressure();
+}
@@ -0,0 +1,49 @@
+/***************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd.
+** Contact: Aaron Kennedy <aaron.kennedy@jollamobile.com>
+**
+** This file is part of lipstick.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef MEMORYPRESSUREMONITOR_H
+#define MEMORYPRESSUREMONITOR_H
+
+#include <QObject>
+
+class QSocketNotifier;
+
+/*!
+ * Emits memoryPressure() when the kernel reports memory stalls through the
+ * pressure stall information interface, /proc/pressure/memory. On kernels
+ * without PSI the monitor stays silent and isAvailable() returns false.
+ */
+class MemoryPressureMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MemoryPressureMonitor(QObject *parent = 0);
+    ~MemoryPressureMonitor();
+
+    bool isAvailable() const;
+
+signals:
+    void memoryPressure();
+
+private slots:
+    void pressureEvent();
+
+private:
+    int m_fd;
+    QSocketNotifier *m_notifier;
+};
+
+#endif // MEMORYPRESSUREMONITOR_H
@@ -19,7 +19,7 @@
 #include "windowmodel.h"
 
 WindowModel::WindowModel()
-: m_complete(false)
+: m_complete(false), m_statisticsEnabled(false)
 {
     LipstickCompositor *c = LipstickCompositor::instance();
     if (!c) {
@@ -31,12 +31,22 @@ WindowModel::WindowModel()
     QDBusConnection dbus = QDBusConnection::sessionBus();
     dbus.registerObject("/WindowModel", this, QDBusConnection::ExportAllSlots);
     dbus.registerService("org.nemomobile.lipstick");
+
+    m_statisticsWatcher.setConnection(dbus);
+    m_statisticsWatcher.setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
+    connect(&m_statisticsWatcher, SIGNAL(serviceUnregistered(QString)), this, SLOT(statisticsSubscriberGone(QString)));
 }
 
 WindowModel::~WindowModel()
 {
     LipstickCompositor *c = LipstickCompositor::instance();
-    if (c) c->m_windowModels.removeAll(this);
+    if (c) {
+        c->m_windowModels.removeAll(this);
+
+        int subscribers = m_statisticsWatcher.watchedServices().count() + (m_statisticsEnabled ? 1 : 0);
+        for (int ii = 0; ii < subscribers; ++ii)
+            c->unsubscribeWindowStatistics();
+    }
 }
 
 int WindowModel::itemCount() const
@@ -44,6 +54,33 @@ int WindowModel::itemCount() const
     return m_items.count();
 }
 
+/*!
+    Whether the commit, damaged pixel, frame callback and input event rate
+    roles are kept up to date. The rates are sampled once a second while
+    any model or D-Bus client has asked for them, and not at all otherwise.
+*/
+bool WindowModel::statisticsEnabled() const
+{
+    return m_statisticsEnabled;
+}
+
+void WindowModel::setStatisticsEnabled(bool enabled)
+{
+    if (m_statisticsEnabled == enabled)
+        return;
+
+    LipstickCompositor *c = LipstickCompositor::instance();
+    if (!c)
+        return;
+
+    m_statisticsEnabled = enabled;
+    if (enabled)
+        c->subscribeWindowStatistics();
+    else
+        c->unsubscribeWindowStatistics();
+    emit statisticsEnabledChanged();
+}
+
 int WindowModel::windowId(int index) const
 {
     if (index < 0 || index >= m_items.count())
@@ -71,6 +108,16 @@ QVariant WindowModel::data(const QModelIndex &index, int role) const
     } else if (role == Qt::UserRole + 3) {
         LipstickCompositorWindow *w = static_cast<LipstickCompositorWindow *>(c->windowForId(m_items.at(idx)));
         return w->title();
+    } else if (role >= Qt::UserRole + 4 && role <= Qt::UserRole + 8) {
+        LipstickCompositorWindow *w = static_cast<LipstickCompositorWindow *>(c->windowForId(m_items.at(idx)));
+        WindowStatistics rate = w->statisticsRate();
+        switch (role - Qt::UserRole) {
+        case 4: return rate.commits;
+        case 5: return rate.damagedPixels;
+        case 6: return rate.frameCallbacks;
+        case 7: return rate.inputEvents;
+        default: return w->bufferBytes();
+        }
     } else {
         return QVariant();
     }
@@ -82,6 +129,11 @@ QHash<int, QByteArray> WindowModel::roleNames() const
     roles[Qt::UserRole + 1] = "window";
     roles[Qt::UserRole + 2] = "processId";
     roles[Qt::UserRole + 3] = "title";
+    roles[Qt::UserRole + 4] = "commitRate";
+    roles[Qt::UserRole + 5] = "damagedPixelRate";
+    roles[Qt::UserRole + 6] = "frameCallbackRate";
+    roles[Qt::UserRole + 7] = "inputEventRate";
+    roles[Qt::UserRole + 8] = "bufferMemory";
     return roles;
 }
 
@@ -114,10 +166,14 @@ void WindowModel::addItem(int id)
     if (!approveWindow(window))
         return;
 
-    beginInsertRows(QModelIndex(), m_items.count(), m_items.count());
-    m_items.append(id);
+    // New windows get the highest id so far, so they normally go last
+    QList<int>::const_iterator it = qLowerBound(m_items, id);
+    Q_ASSERT(it == m_items.constEnd() || *it != id);
+    int idx = it - m_items.constBegin();
+    beginInsertRows(QModelIndex(), idx, idx);
+    m_items.insert(idx, id);
     endInsertRows();
-    emit itemAdded(m_items.count() - 1);
+    emit itemAdded(idx);
     emit itemCountChanged();
 }
 
@@ -126,7 +182,7 @@ void WindowModel::remItem(int id)
     if (!m_complete)
         return;
 
-    int idx = m_items.indexOf(id);
+    int idx = row(id);
     if (idx == -1)
         return;
 
@@ -141,13 +197,107 @@ void WindowModel::titleChanged(int id)
     if (!m_complete)
         return;
 
-    int idx = m_items.indexOf(id);
+    int idx = row(id);
     if (idx == -1)
         return;
 
     emit dataChanged(index(idx, 0), index(idx, 0));
 }
 
+void WindowModel::statisticsChanged()
+{
+    if (!m_complete || m_items.isEmpty())
+        return;
+
+    QVector<int> roles;
+    for (int role = Qt::UserRole + 4; role <= Qt::UserRole + 8; ++role)
+        roles.append(role);
+
+    emit dataChanged(index(0, 0), index(m_items.count() - 1, 0), roles);
+}
+
+/*!
+    Returns the per second commit, damaged pixel, frame callback and input
+    event rates and the buffer memory of every window, and the same summed
+    up per client process. Exported on D-Bus for monitoring.
+
+    The rates are the ones of the last completed one second sample, see
+    subscribeStatistics().
+*/
+QVariantMap WindowModel::windowStatistics() const
+{
+    LipstickCompositor *c = LipstickCompositor::instance();
+    if (!c)
+        return QVariantMap();
+
+    QVariantList windows;
+    QMap<qint64, QVariantMap> processes;
+
+    foreach (LipstickCompositorWindow *w, c->m_mappedSurfaces) {
+        WindowStatistics rate = w->statisticsRate();
+
+        QVariantMap window;
+        window.insert("window", w->windowId());
+        window.insert("processId", w->processId());
+        window.insert("title", w->title());
+        window.insert("category", w->category());
+        window.insert("commitRate", rate.commits);
+        window.insert("damagedPixelRate", rate.damagedPixels);
+        window.insert("frameCallbackRate", rate.frameCallbacks);
+        window.insert("inputEventRate", rate.inputEvents);
+        window.insert("bufferMemory", w->bufferBytes());
+        windows.append(window);
+
+        QVariantMap &process = processes[w->processId()];
+        process.insert("processId", w->processId());
+        process.insert("windowCount", process.value("windowCount").toInt() + 1);
+        foreach (const QString &key, QStringList() << "commitRate" << "damagedPixelRate"
+                                                   << "frameCallbackRate" << "inputEventRate"
+                                                   << "bufferMemory")
+            process.insert(key, process.value(key).toLongLong() + window.value(key).toLongLong());
+    }
+
+    QVariantList processList;
+    foreach (const QVariantMap &process, processes)
+        processList.append(process);
+
+    QVariantMap statistics;
+    statistics.insert("windows", windows);
+    statistics.insert("processes", processList);
+    return statistics;
+}
+
+/*!
+    Starts sampling the window statistics for the calling D-Bus client until
+    it calls unsubscribeStatistics() or leaves the bus.
+*/
+void WindowModel::subscribeStatistics()
+{
+    LipstickCompositor *c = LipstickCompositor::instance();
+    if (!calledFromDBus() || !c)
+        return;
+
+    QString service = message().service();
+    if (m_statisticsWatcher.watchedServices().contains(service))
+        return;
+
+    m_statisticsWatcher.addWatchedService(service);
+    c->subscribeWindowStatistics();
+}
+
+void WindowModel::unsubscribeStatistics()
+{
+    if (calledFromDBus())
+        statisticsSubscriberGone(message().service());
+}
+
+void WindowModel::statisticsSubscriberGone(const QString &service)
+{
+    LipstickCompositor *c = LipstickCompositor::instance();
+    if (m_statisticsWatcher.removeWatchedService(service) && c)
+        c->unsubscribeWindowStatistics();
+}
+
 void WindowModel::refresh()
 {
     LipstickCompositor *c = LipstickCompositor::instance();
@@ -158,16 +308,22 @@ void WindowModel::refresh()
 
     m_items.clear();
 
-    for (QHash<int, LipstickCompositorWindow *>::ConstIterator iter = c->m_mappedSurfaces.begin();
-         iter != c->m_mappedSurfaces.end(); ++iter) {
-
-        if (approveWindow(iter.value()))
-            m_items.append(iter.key());
+    for (QHash<int, LipstickCompositorWindow *>::const_iterator it = c->m_mappedSurfaces.constBegin();
+         it != c->m_mappedSurfaces.constEnd(); ++it) {
+        if (approveWindow(it.value()))
+            m_items.append(it.key());
     }
+    qSort(m_items);
 
     endResetModel();
 }
 
+int WindowModel::row(int id) const
+{
+    QList<int>::const_iterator it = qBinaryFind(m_items, id);
+    return it != m_items.constEnd() ? it - m_items.constBegin() : -1;
+}
+
 // used by mapplauncherd to bring a binary to the front
 void WindowModel::launchProcess(const QString &binaryName)
 {
@@ -175,52 +331,18 @@ void WindowModel::launchProcess(const QString &binaryName)
     if (!m_complete || !c)
         return;
 
-    QStringList binaryParts = binaryName.split(QRegExp(QRegExp("\\s+")));
-
-    for (QHash<int, LipstickCompositorWindow *>::ConstIterator iter = c->m_mappedSurfaces.begin();
-        iter != c->m_mappedSurfaces.end(); ++iter) {
-
-        LipstickCompositorWindow *win = iter.value();
-        if (!approveWindow(win))
-            continue;
-
-        QString pidFile = QString::fromLatin1("/proc/%1/cmdline").arg(win->processId());
-        QFile f(pidFile);
-        if (!f.open(QIODevice::ReadOnly)) {
-            qWarning() << Q_FUNC_INFO << "Cannot open cmdline for " << pidFile;
-            continue;
-        }
-
-        // Command line arguments are split by '\0' in /proc/*/cmdline
-        QStringList proc;
-        QByteArray data = f.readAll();
-        Q_FOREACH (const QByteArray &array, data.split('\0')) {
-            QString part = QString::fromUtf8(array);
-            if (part.size() > 0) {
-                proc << part;
-            }
-        }
-
-        // Cannot match, as the cmdline has less arguments than then binary part
-        if (binaryParts.size() > proc.size()) {
-            continue;
-        }
-
-        bool match = true;
-
-        // All parts of binaryName must be contained in this order in the
-        // process command line to match the given process
-        for (int i=0; i<binaryParts.count(); i++) {
-            if (proc[i] != binaryParts[i]) {
-                match = false;
-                break;
-            }
-        }
+    // All parts of binaryName must be contained in this order in the
+    // process command line to match the given process. A desktop file id
+    // matches the windows of the application started from it.
+    QList<int> ids = binaryName.endsWith(QLatin1String(".desktop"))
+            ? c->windowIdsForDesktopFile(binaryName)
+            : c->windowIdsForCommand(binaryName);
 
-        if (match) {
+    foreach (int id, ids) {
+        LipstickCompositorWindow *win = c->m_mappedSurfaces.value(id, 0);
+        if (win && approveWindow(win)) {
             win->surface()->raiseRequested();
             break;
         }
     }
 }
-
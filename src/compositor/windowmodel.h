@@ -19,22 +19,28 @@
 #include "lipstickglobal.h"
 #include <QQmlParserStatus>
 #include <QAbstractListModel>
+#include <QDBusContext>
+#include <QDBusServiceWatcher>
 
 class LipstickCompositor;
 class LipstickCompositorWindow;
 class LIPSTICK_EXPORT WindowModel : public QAbstractListModel,
-                                    public QQmlParserStatus
+                                    public QQmlParserStatus,
+                                    protected QDBusContext
 {
     Q_OBJECT
     Q_INTERFACES(QQmlParserStatus)
 
     Q_PROPERTY(int itemCount READ itemCount NOTIFY itemCountChanged)
+    Q_PROPERTY(bool statisticsEnabled READ statisticsEnabled WRITE setStatisticsEnabled NOTIFY statisticsEnabledChanged)
 
 public:
     WindowModel();
     ~WindowModel();
 
     int itemCount() const;
+    bool statisticsEnabled() const;
+    void setStatisticsEnabled(bool);
     Q_INVOKABLE int windowId(int) const;
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
@@ -44,6 +50,7 @@ public:
 signals:
     void itemCountChanged();
     void itemAdded(int index);
+    void statisticsEnabledChanged();
 
 protected:
     virtual void classBegin();
@@ -53,6 +60,12 @@ protected:
 
 public slots:
     void launchProcess(const QString &binaryName);
+    QVariantMap windowStatistics() const;
+    void subscribeStatistics();
+    void unsubscribeStatistics();
+
+private slots:
+    void statisticsSubscriberGone(const QString &service);
 
 private:
     friend class LipstickCompositor;
@@ -61,11 +74,17 @@ private:
     void addItem(int);
     void remItem(int);
     void titleChanged(int);
+    void statisticsChanged();
 
     void refresh();
+    int row(int id) const;
 
     bool m_complete:1;
+    bool m_statisticsEnabled:1;
+    // Sorted by window id, which is also the order the windows were mapped in
     QList<int> m_items;
+    // D-Bus clients subscribed to the window statistics
+    QDBusServiceWatcher m_statisticsWatcher;
 };
 
 #endif // WINDOWMODEL_H
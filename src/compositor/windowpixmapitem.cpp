@@ -13,35 +13,76 @@
 **
 ****************************************************************************/
 
-#include <QtCore/qmath.h>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QQuickWindow>
+#include <qmath.h>
 #include <QSGGeometryNode>
-#include <QSGSimpleMaterial>
+#include <QSGMaterial>
+#include <QSGTexture>
+#include <QVector4D>
+#include <QWaylandSurface>
 #include <QWaylandSurfaceItem>
 #include "lipstickcompositorwindow.h"
+#include "lipstickcompositorprocwindow.h"
 #include "lipstickcompositor.h"
 #include "windowpixmapitem.h"
 
 namespace {
 
-class SurfaceTextureState {
-public:
-    SurfaceTextureState() : m_texture(0) {}
-    void setTexture(QSGTexture *texture) { m_texture = texture; }
-    QSGTexture *texture() const { return m_texture; }
-
-private:
-    QSGTexture *m_texture;
+// Every vertex carries the cover's corner parameters, so that the material
+// has no per-node uniforms and the renderer is free to merge covers that
+// share a texture into one draw call.
+struct SurfaceVertex {
+    float x, y;
+    float tx, ty;
+    float offsetX, offsetY;
+    float halfWidth, halfHeight;
+    float topLeftRadius, topRightRadius, bottomRightRadius, bottomLeftRadius;
 };
 
-class SurfaceTextureMaterial : public QSGSimpleMaterialShader<SurfaceTextureState>
+const QSGGeometry::AttributeSet &surfaceAttributes()
+{
+    static QSGGeometry::Attribute attributes[] = {
+        QSGGeometry::Attribute::create(0, 2, GL_FLOAT, true),
+        QSGGeometry::Attribute::create(1, 2, GL_FLOAT),
+        QSGGeometry::Attribute::create(2, 2, GL_FLOAT),
+        QSGGeometry::Attribute::create(3, 2, GL_FLOAT),
+        QSGGeometry::Attribute::create(4, 4, GL_FLOAT)
+    };
+    static QSGGeometry::AttributeSet attributeSet = { 5, sizeof(SurfaceVertex), attributes };
+    return attributeSet;
+}
+
+class SurfaceTextureShader : public QSGMaterialShader
 {
-    QSG_DECLARE_SIMPLE_SHADER(SurfaceTextureMaterial, SurfaceTextureState)
 public:
-    QList<QByteArray> attributes() const;
-    void updateState(const SurfaceTextureState *newState, const SurfaceTextureState *oldState);
+    SurfaceTextureShader() : m_matrixId(-1), m_opacityId(-1) {}
+    char const *const *attributeNames() const;
+    void updateState(const RenderState &state, QSGMaterial *newMaterial, QSGMaterial *oldMaterial);
 protected:
+    void initialize();
     const char *vertexShader() const;
     const char *fragmentShader() const;
+
+private:
+    int m_matrixId;
+    int m_opacityId;
+};
+
+class SurfaceTextureMaterial : public QSGMaterial
+{
+public:
+    SurfaceTextureMaterial() : m_texture(0) {}
+    QSGMaterialType *type() const;
+    QSGMaterialShader *createShader() const;
+    int compare(const QSGMaterial *other) const;
+
+    void setTexture(QSGTexture *texture) { m_texture = texture; }
+    QSGTexture *texture() const { return m_texture; }
+
+private:
+    QSGTexture *m_texture;
 };
 
 class SurfaceNode : public QObject, public QSGGeometryNode
@@ -49,10 +90,16 @@ class SurfaceNode : public QObject, public QSGGeometryNode
     Q_OBJECT
 public:
     SurfaceNode();
+    ~SurfaceNode();
     void setRect(const QRectF &);
     void setTextureProvider(QSGTextureProvider *);
-    void setBlending(bool);
-    void setRadius(qreal radius);
+    void setThumbnail(QSGTexture *, qint64 key);
+    qint64 thumbnailKey() const { return m_thumbnailKey; }
+
+    enum Blending { AutoBlending, NoBlending, AlwaysBlending };
+    void setBlending(Blending);
+    bool textureOpaque() const { return m_texture && !m_texture->hasAlphaChannel(); }
+    void setRadii(const QVector4D &radii);
 
 private slots:
     void providerDestroyed();
@@ -61,61 +108,131 @@ private slots:
 private:
     void setTexture(QSGTexture *texture);
     void updateGeometry();
+    void updateRadii();
+    void updateBlending();
 
-    QSGSimpleMaterial<SurfaceTextureState> *m_material;
+    SurfaceTextureMaterial m_material;
     QRectF m_rect;
-    qreal m_radius;
+    QVector4D m_radii;
+    QVector4D m_clampedRadii;
+    Blending m_blending;
 
     QSGTextureProvider *m_provider;
     QSGTexture *m_texture;
+    QSGTexture *m_thumbnail;
+    qint64 m_thumbnailKey;
     QSGGeometry m_geometry;
     QRectF m_textureRect;
 };
 
-QList<QByteArray> SurfaceTextureMaterial::attributes() const
+char const *const *SurfaceTextureShader::attributeNames() const
+{
+    static char const *const attributes[] = {
+        "qt_VertexPosition",
+        "qt_VertexTexCoord",
+        "vertexOffset",
+        "vertexHalfSize",
+        "vertexRadii",
+        0
+    };
+    return attributes;
+}
+
+void SurfaceTextureShader::initialize()
 {
-    QList<QByteArray> attributeList;
-    attributeList << "qt_VertexPosition";
-    attributeList << "qt_VertexTexCoord";
-    return attributeList;
+    m_matrixId = program()->uniformLocation("qt_Matrix");
+    m_opacityId = program()->uniformLocation("qt_Opacity");
 }
 
-void SurfaceTextureMaterial::updateState(const SurfaceTextureState *newState,
-                                         const SurfaceTextureState *)
+void SurfaceTextureShader::updateState(const RenderState &state, QSGMaterial *newMaterial,
+                                       QSGMaterial *)
 {
-    if (newState->texture())
-        newState->texture()->bind();
+    SurfaceTextureMaterial *material = static_cast<SurfaceTextureMaterial *>(newMaterial);
+    if (material->texture())
+        material->texture()->bind();
+
+    if (state.isMatrixDirty())
+        program()->setUniformValue(m_matrixId, state.combinedMatrix());
+    if (state.isOpacityDirty())
+        program()->setUniformValue(m_opacityId, state.opacity());
 }
 
-const char *SurfaceTextureMaterial::vertexShader() const
+const char *SurfaceTextureShader::vertexShader() const
 {
     return "uniform highp mat4 qt_Matrix;                      \n"
            "attribute highp vec4 qt_VertexPosition;            \n"
            "attribute highp vec2 qt_VertexTexCoord;            \n"
+           "attribute highp vec2 vertexOffset;                 \n"
+           "attribute highp vec2 vertexHalfSize;               \n"
+           "attribute highp vec4 vertexRadii;                  \n"
            "varying highp vec2 qt_TexCoord;                    \n"
+           "varying highp vec2 offset;                         \n"
+           "varying highp vec2 halfSize;                       \n"
+           "varying highp vec4 radii;                          \n"
            "void main() {                                      \n"
            "    qt_TexCoord = qt_VertexTexCoord;               \n"
+           "    offset = vertexOffset;                         \n"
+           "    halfSize = vertexHalfSize;                     \n"
+           "    radii = vertexRadii;                           \n"
            "    gl_Position = qt_Matrix * qt_VertexPosition;   \n"
            "}";
 }
 
-const char *SurfaceTextureMaterial::fragmentShader() const
+// The corners are masked with the signed distance to a rounded rectangle,
+// so the cover is always a single quad regardless of the radii. The radii
+// are given as (top left, top right, bottom right, bottom left) and the
+// one pixel wide coverage ramp around the edge provides anti-aliasing.
+const char *SurfaceTextureShader::fragmentShader() const
 {
     return "varying highp vec2 qt_TexCoord;                    \n"
+           "varying highp vec2 offset;                         \n"
+           "varying highp vec2 halfSize;                       \n"
+           "varying highp vec4 radii;                          \n"
            "uniform sampler2D qt_Texture;                      \n"
            "uniform lowp float qt_Opacity;                     \n"
            "void main() {                                      \n"
-           "    gl_FragColor = texture2D(qt_Texture, qt_TexCoord) * qt_Opacity; \n"
+           "    highp vec2 r = offset.x < 0.0 ? radii.xw : radii.yz; \n"
+           "    highp float radius = offset.y < 0.0 ? r.x : r.y; \n"
+           "    highp vec2 q = abs(offset) - halfSize + radius; \n"
+           "    highp float d = min(max(q.x, q.y), 0.0) + length(max(q, 0.0)) - radius; \n"
+           "    lowp float coverage = clamp(0.5 - d, 0.0, 1.0); \n"
+           "    gl_FragColor = texture2D(qt_Texture, qt_TexCoord) * (qt_Opacity * coverage); \n"
            "}";
 }
 
+QSGMaterialType *SurfaceTextureMaterial::type() const
+{
+    static QSGMaterialType type;
+    return &type;
+}
+
+QSGMaterialShader *SurfaceTextureMaterial::createShader() const
+{
+    return new SurfaceTextureShader;
+}
+
+int SurfaceTextureMaterial::compare(const QSGMaterial *other) const
+{
+    // Covers only differ by their texture, everything else is in the vertices
+    const SurfaceTextureMaterial *o = static_cast<const SurfaceTextureMaterial *>(other);
+    int id = m_texture ? m_texture->textureId() : 0;
+    int otherId = o->m_texture ? o->m_texture->textureId() : 0;
+    return id - otherId;
+}
+
 SurfaceNode::SurfaceNode()
-: m_material(0), m_radius(0), m_provider(0), m_texture(0),
-  m_geometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 0)
+: m_blending(AutoBlending), m_provider(0), m_texture(0), m_thumbnail(0), m_thumbnailKey(0),
+  m_geometry(surfaceAttributes(), 4)
 {
+    m_geometry.setDrawingMode(GL_TRIANGLE_STRIP);
     setGeometry(&m_geometry);
-    m_material = SurfaceTextureMaterial::createMaterial();
-    setMaterial(m_material);
+    m_material.setFlag(QSGMaterial::Blending, true);
+    setMaterial(&m_material);
+}
+
+SurfaceNode::~SurfaceNode()
+{
+    delete m_thumbnail;
 }
 
 void SurfaceNode::setRect(const QRectF &r)
@@ -125,7 +242,7 @@ void SurfaceNode::setRect(const QRectF &r)
 
     m_rect = r;
 
-    updateGeometry();
+    updateRadii();
 }
 
 void SurfaceNode::setTextureProvider(QSGTextureProvider *p)
@@ -133,6 +250,12 @@ void SurfaceNode::setTextureProvider(QSGTextureProvider *p)
     if (p == m_provider)
         return;
 
+    if (m_thumbnail) {
+        delete m_thumbnail;
+        m_thumbnail = 0;
+        m_thumbnailKey = 0;
+    }
+
     if (m_provider) {
         QObject::disconnect(m_provider, SIGNAL(destroyed(QObject *)), this, SLOT(providerDestroyed()));
         QObject::disconnect(m_provider, SIGNAL(textureChanged()), this, SLOT(textureChanged()));
@@ -147,88 +270,113 @@ void SurfaceNode::setTextureProvider(QSGTextureProvider *p)
     setTexture(m_provider->texture());
 }
 
-void SurfaceNode::updateGeometry()
+void SurfaceNode::setThumbnail(QSGTexture *thumbnail, qint64 key)
 {
-    if (m_texture) {
-        QSize ts = m_texture->textureSize();
-        QRectF sourceRect(0, 0, ts.width(), ts.height());
-        QRectF textureRect = m_texture->convertToNormalizedSourceRect(sourceRect);
-
-        if (m_radius) {
-            float radius = qMin(float(qMin(m_rect.width(), m_rect.height()) * 0.5f), float(m_radius));
-            int segments = qBound(5, qCeil(radius * (M_PI / 6)), 18);
-            float angle = 0.5f * float(M_PI) / segments;
-
-            m_geometry.allocate((segments + 1) * 2 * 2);
-
-            QSGGeometry::TexturedPoint2D *v = m_geometry.vertexDataAsTexturedPoint2D();
-            QSGGeometry::TexturedPoint2D *vlast = v + (segments + 1) * 2 * 2 - 2;
-
-            float textureXRadius = radius * textureRect.width() / m_rect.width();
-            float textureYRadius = radius * textureRect.height() / m_rect.height();
-
-            float c = 1; float cosStep = qFastCos(angle);
-            float s = 0; float sinStep = qFastSin(angle);
-
-            for (int ii = 0; ii <= segments; ++ii) {
-                float px = m_rect.left() + radius - radius * c;
-                float tx = textureRect.left() + textureXRadius - textureXRadius * c;
-
-                float px2 = m_rect.right() - radius + radius * c;
-                float tx2 = textureRect.right() - textureXRadius + textureXRadius * c;
+    // The node owns the thumbnail texture, unlike the provider's texture
+    if (m_provider) {
+        QObject::disconnect(m_provider, SIGNAL(destroyed(QObject *)), this, SLOT(providerDestroyed()));
+        QObject::disconnect(m_provider, SIGNAL(textureChanged()), this, SLOT(textureChanged()));
+        m_provider = 0;
+    }
 
-                float py = m_rect.top() + radius - radius * s;
-                float ty = textureRect.top() + textureYRadius - textureYRadius * s;
+    setTexture(thumbnail);
 
-                float py2 = m_rect.bottom() - radius + radius * s;
-                float ty2 = textureRect.bottom() - textureYRadius + textureYRadius * s;
+    delete m_thumbnail;
+    m_thumbnail = thumbnail;
+    m_thumbnailKey = key;
+}
 
-                v[0].x = px; v[0].y = py;
-                v[0].tx = tx; v[0].ty = ty;
+void SurfaceNode::updateGeometry()
+{
+    if (!m_texture)
+        return;
 
-                v[1].x = px; v[1].y = py2;
-                v[1].tx = tx; v[1].ty = ty2;
+    SurfaceVertex *v = static_cast<SurfaceVertex *>(m_geometry.vertexData());
+
+    float halfWidth = m_rect.width() * 0.5f;
+    float halfHeight = m_rect.height() * 0.5f;
+
+    const float xs[] = { float(m_rect.left()), float(m_rect.right()) };
+    const float ys[] = { float(m_rect.top()), float(m_rect.bottom()) };
+    const float txs[] = { float(m_textureRect.left()), float(m_textureRect.right()) };
+    const float tys[] = { float(m_textureRect.top()), float(m_textureRect.bottom()) };
+
+    // Triangle strip order: top left, bottom left, top right, bottom right
+    for (int ii = 0; ii < 4; ++ii) {
+        int xi = ii / 2;
+        int yi = ii % 2;
+
+        v[ii].x = xs[xi];
+        v[ii].y = ys[yi];
+        v[ii].tx = txs[xi];
+        v[ii].ty = tys[yi];
+        v[ii].offsetX = xi ? halfWidth : -halfWidth;
+        v[ii].offsetY = yi ? halfHeight : -halfHeight;
+        v[ii].halfWidth = halfWidth;
+        v[ii].halfHeight = halfHeight;
+        v[ii].topLeftRadius = m_clampedRadii.x();
+        v[ii].topRightRadius = m_clampedRadii.y();
+        v[ii].bottomRightRadius = m_clampedRadii.z();
+        v[ii].bottomLeftRadius = m_clampedRadii.w();
+    }
 
-                vlast[0].x = px2; vlast[0].y = py;
-                vlast[0].tx = tx2; vlast[0].ty = ty;
+    markDirty(DirtyGeometry);
+}
 
-                vlast[1].x = px2; vlast[1].y = py2;
-                vlast[1].tx = tx2; vlast[1].ty = ty2;
+void SurfaceNode::updateRadii()
+{
+    // Clamp each corner so that adjacent corners never overlap
+    float maxRadius = qMax(0.0f, float(qMin(m_rect.width(), m_rect.height()) * 0.5f));
+    QVector4D radii(qBound(0.0f, m_radii.x(), maxRadius), qBound(0.0f, m_radii.y(), maxRadius),
+                    qBound(0.0f, m_radii.z(), maxRadius), qBound(0.0f, m_radii.w(), maxRadius));
 
-                v += 2;
-                vlast -= 2;
+    m_clampedRadii = radii;
 
-                float t = c;
-                c = c * cosStep - s * sinStep;
-                s = s * cosStep + t * sinStep;
-            }
-        } else {
-            m_geometry.allocate(4);
-            QSGGeometry::updateTexturedRectGeometry(&m_geometry, m_rect, textureRect);
-        }
+    updateBlending();
+    updateGeometry();
+}
 
-        markDirty(DirtyGeometry);
+void SurfaceNode::updateBlending()
+{
+    // Without blending the renderer draws the node in its front to back opaque
+    // pass, so whatever it covers is rejected by the depth test instead of
+    // being overdrawn. The masked corners are transparent, so they need
+    // blending even if the texture is opaque.
+    bool blending = !m_clampedRadii.isNull();
+    if (m_blending == AlwaysBlending)
+        blending = true;
+    else if (m_blending == AutoBlending && !textureOpaque())
+        blending = true;
+
+    if (m_material.flags().testFlag(QSGMaterial::Blending) != blending) {
+        m_material.setFlag(QSGMaterial::Blending, blending);
+        markDirty(DirtyMaterial);
     }
 }
 
-void SurfaceNode::setBlending(bool b)
+void SurfaceNode::setBlending(Blending b)
 {
-    m_material->setFlag(QSGMaterial::Blending, b);
+    if (m_blending == b)
+        return;
+
+    m_blending = b;
+
+    updateBlending();
 }
 
-void SurfaceNode::setRadius(qreal radius)
+void SurfaceNode::setRadii(const QVector4D &radii)
 {
-    if (m_radius == radius)
+    if (m_radii == radii)
         return;
 
-    m_radius = radius;
+    m_radii = radii;
 
-    updateGeometry();
+    updateRadii();
 }
 
 void SurfaceNode::setTexture(QSGTexture *texture)
 {
-    m_material->state()->setTexture(texture);
+    m_material.setTexture(texture);
 
     QRectF tr;
     if (texture) tr = texture->convertToNormalizedSourceRect(QRect(QPoint(0,0), texture->textureSize()));
@@ -240,6 +388,9 @@ void SurfaceNode::setTexture(QSGTexture *texture)
 
     if (ug) updateGeometry();
 
+    // A client may switch to a buffer format with or without alpha at any time
+    updateBlending();
+
     markDirty(DirtyMaterial);
 }
 
@@ -254,12 +405,54 @@ void SurfaceNode::providerDestroyed()
     setTexture(0);
 }
 
+// Reads the texture back and scales it down to size. Must be called with the
+// scene graph's context current; the framebuffer binding is restored afterwards.
+QImage grabThumbnail(QSGTexture *texture, const QSize &size, bool opaque)
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    QSize textureSize = texture->textureSize();
+    if (!context || textureSize.isEmpty() || size.isEmpty())
+        return QImage();
+
+    QOpenGLFunctions *gl = context->functions();
+
+    GLint previousFbo = 0;
+    gl->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+
+    GLuint fbo = 0;
+    gl->glGenFramebuffers(1, &fbo);
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->textureId(), 0);
+
+    QImage image;
+    if (gl->glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
+        // GL_RGBA is the one read format GLES2 guarantees; swap it to ARGB afterwards
+        image = QImage(textureSize, QImage::Format_ARGB32_Premultiplied);
+        gl->glReadPixels(0, 0, textureSize.width(), textureSize.height(), GL_RGBA, GL_UNSIGNED_BYTE, image.bits());
+        image = image.rgbSwapped().scaled(size.boundedTo(textureSize), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        // Keeps the thumbnail texture opaque as well, see SurfaceNode::updateBlending()
+        if (opaque)
+            image = image.convertToFormat(QImage::Format_RGB32);
+    }
+
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+    gl->glDeleteFramebuffers(1, &fbo);
+
+    return image;
+}
+
 }
 
 WindowPixmapItem::WindowPixmapItem()
-: m_item(0), m_shaderEffect(0), m_id(0), m_opaque(false), m_radius(0)
+: m_item(0), m_id(0), m_opaque(false), m_opaqueSet(false), m_textureOpaque(false), m_radius(0),
+  m_topLeftRadius(-1), m_topRightRadius(-1), m_bottomRightRadius(-1), m_bottomLeftRadius(-1),
+  m_updatePolicy(Live), m_updateRate(0)
 {
     setFlag(ItemHasContents);
+
+    LipstickCompositor *c = LipstickCompositor::instance();
+    if (c)
+        QObject::connect(c, SIGNAL(windowRemoved(QObject*)), this, SLOT(windowRemoved(QObject*)));
 }
 
 WindowPixmapItem::~WindowPixmapItem()
@@ -278,30 +471,54 @@ void WindowPixmapItem::setWindowId(int id)
         return;
     
     if (m_item) {
-        m_item->imageRelease();
-        m_item = 0;
+        if (m_item->isInProcess())
+            static_cast<LipstickCompositorProcWindow *>(m_item)->layerRelease();
+        detachItem();
     }
 
+    m_thumbnail = QImage();
     m_id = id;
     updateItem();
 
     emit windowIdChanged();
 }
 
+/*!
+    By default the item is opaque when the window's shared memory buffer has
+    no alpha channel; windows drawing with EGL are always blended, as their
+    buffer format is not known. Setting opaque overrides that, resetting it
+    to undefined restores the default.
+*/
 bool WindowPixmapItem::opaque() const
 {
-    return m_opaque;
+    return m_opaqueSet ? m_opaque : m_textureOpaque;
 }
 
 void WindowPixmapItem::setOpaque(bool o)
 {
-    if (m_opaque == o)
+    if (m_opaqueSet && m_opaque == o)
         return;
 
+    bool wasOpaque = opaque();
     m_opaque = o;
-    if (m_item) update();
+    m_opaqueSet = true;
+    if (m_item || !m_thumbnail.isNull()) update();
+
+    if (opaque() != wasOpaque)
+        emit opaqueChanged();
+}
+
+void WindowPixmapItem::resetOpaque()
+{
+    if (!m_opaqueSet)
+        return;
+
+    bool wasOpaque = opaque();
+    m_opaqueSet = false;
+    if (m_item || !m_thumbnail.isNull()) update();
 
-    emit opaqueChanged();
+    if (opaque() != wasOpaque)
+        emit opaqueChanged();
 }
 
 qreal WindowPixmapItem::radius() const
@@ -315,35 +532,216 @@ void WindowPixmapItem::setRadius(qreal r)
         return;
 
     m_radius = r;
-    if (m_item) update();
+    if (m_item || !m_thumbnail.isNull()) update();
 
     emit radiusChanged();
+
+    if (m_topLeftRadius < 0) emit topLeftRadiusChanged();
+    if (m_topRightRadius < 0) emit topRightRadiusChanged();
+    if (m_bottomRightRadius < 0) emit bottomRightRadiusChanged();
+    if (m_bottomLeftRadius < 0) emit bottomLeftRadiusChanged();
+}
+
+/*!
+    The per-corner radii override radius for a single corner. A negative
+    value, which is the default, makes the corner follow radius.
+*/
+qreal WindowPixmapItem::topLeftRadius() const
+{
+    return m_topLeftRadius < 0 ? m_radius : m_topLeftRadius;
+}
+
+void WindowPixmapItem::setTopLeftRadius(qreal r)
+{
+    if (m_topLeftRadius == r)
+        return;
+
+    m_topLeftRadius = r;
+    if (m_item || !m_thumbnail.isNull()) update();
+
+    emit topLeftRadiusChanged();
+}
+
+qreal WindowPixmapItem::topRightRadius() const
+{
+    return m_topRightRadius < 0 ? m_radius : m_topRightRadius;
+}
+
+void WindowPixmapItem::setTopRightRadius(qreal r)
+{
+    if (m_topRightRadius == r)
+        return;
+
+    m_topRightRadius = r;
+    if (m_item || !m_thumbnail.isNull()) update();
+
+    emit topRightRadiusChanged();
+}
+
+qreal WindowPixmapItem::bottomRightRadius() const
+{
+    return m_bottomRightRadius < 0 ? m_radius : m_bottomRightRadius;
+}
+
+void WindowPixmapItem::setBottomRightRadius(qreal r)
+{
+    if (m_bottomRightRadius == r)
+        return;
+
+    m_bottomRightRadius = r;
+    if (m_item || !m_thumbnail.isNull()) update();
+
+    emit bottomRightRadiusChanged();
+}
+
+qreal WindowPixmapItem::bottomLeftRadius() const
+{
+    return m_bottomLeftRadius < 0 ? m_radius : m_bottomLeftRadius;
+}
+
+void WindowPixmapItem::setBottomLeftRadius(qreal r)
+{
+    if (m_bottomLeftRadius == r)
+        return;
+
+    m_bottomLeftRadius = r;
+    if (m_item || !m_thumbnail.isNull()) update();
+
+    emit bottomLeftRadiusChanged();
+}
+
+/*!
+    The update policy limits how often the window's client is allowed to
+    draw while the home screen is active and the window is only visible
+    through its covers. Throttled covers update at most updateRate times a
+    second, OnActivate covers once each time the home screen becomes active
+    and Frozen covers not at all. The least restrictive cover of a window
+    decides.
+*/
+WindowPixmapItem::UpdatePolicy WindowPixmapItem::updatePolicy() const
+{
+    return m_updatePolicy;
+}
+
+void WindowPixmapItem::setUpdatePolicy(UpdatePolicy policy)
+{
+    if (m_updatePolicy == policy)
+        return;
+
+    m_updatePolicy = policy;
+    updateThrottling();
+
+    emit updatePolicyChanged();
+}
+
+/*!
+    The maximum number of updates per second for the Throttled policy.
+    Zero, which is the default, does not limit the rate.
+*/
+int WindowPixmapItem::updateRate() const
+{
+    return m_updateRate;
+}
+
+void WindowPixmapItem::setUpdateRate(int rate)
+{
+    if (m_updateRate == rate)
+        return;
+
+    m_updateRate = rate;
+    if (m_updatePolicy == Throttled)
+        updateThrottling();
+
+    emit updateRateChanged();
+}
+
+void WindowPixmapItem::updateThrottling()
+{
+    // Callbacks held under the old policy may be due now
+    LipstickCompositor *c = LipstickCompositor::instance();
+    if (m_item && c && !c->displayOff())
+        c->sendFrameCallbacks();
 }
 
 QSGNode *WindowPixmapItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
 {
     SurfaceNode *node = static_cast<SurfaceNode *>(oldNode);
 
-    if (m_item == 0) {
+    QSGTextureProvider *provider = m_item ? m_item->textureProvider() : 0;
+
+    // Only a texture made from a shared memory buffer has the buffer's format;
+    // one made from an EGL buffer reports the item's useTextureAlpha instead
+    bool shmBuffer = m_item && m_item->surface() && m_item->surface()->type() == QWaylandSurface::Shm;
+
+    if (m_item && m_item->m_downgraded && m_thumbnail.isNull() && provider && provider->texture()) {
+        // Keep a cover sized copy, so that the window's full size buffers can go
+        m_thumbnail = grabThumbnail(provider->texture(), QSize(qCeil(width()), qCeil(height())),
+                                    shmBuffer && !provider->texture()->hasAlphaChannel());
+        if (m_item->m_windowClosed)
+            QMetaObject::invokeMethod(this, "releaseWindow", Qt::QueuedConnection);
+    } else if (m_item && !m_item->m_downgraded) {
+        m_thumbnail = QImage();
+    }
+
+    bool useThumbnail = !m_thumbnail.isNull();
+    if (!useThumbnail && !provider) {
         delete node;
         return 0;
     }
 
     if (!node) node = new SurfaceNode;
 
-    node->setTextureProvider(m_item->textureProvider());
+    if (useThumbnail) {
+        if (node->thumbnailKey() != m_thumbnail.cacheKey())
+            node->setThumbnail(window()->createTextureFromImage(m_thumbnail), m_thumbnail.cacheKey());
+    } else {
+        node->setTextureProvider(provider);
+    }
+
     node->setRect(QRectF(0, 0, width(), height()));
-    node->setBlending(!m_opaque);
-    node->setRadius(m_radius);
+    // The thumbnail's format was settled when it was grabbed
+    bool knownFormat = useThumbnail || shmBuffer;
+    if (!m_opaqueSet)
+        node->setBlending(knownFormat ? SurfaceNode::AutoBlending : SurfaceNode::AlwaysBlending);
+    else
+        node->setBlending(m_opaque ? SurfaceNode::NoBlending : SurfaceNode::AlwaysBlending);
+
+    // The GUI thread is blocked while this runs, so the detected value can be
+    // kept for opaque() directly; the change is announced once it continues
+    bool textureOpaque = knownFormat && node->textureOpaque();
+    if (m_textureOpaque != textureOpaque) {
+        m_textureOpaque = textureOpaque;
+        if (!m_opaqueSet)
+            QMetaObject::invokeMethod(this, "opaqueChanged", Qt::QueuedConnection);
+    }
+    node->setRadii(QVector4D(topLeftRadius(), topRightRadius(), bottomRightRadius(), bottomLeftRadius()));
 
     return node;
 }
 
-void WindowPixmapItem::geometryChanged(const QRectF &n, const QRectF &o)
+void WindowPixmapItem::windowRemoved(QObject *window)
 {
-    QQuickItem::geometryChanged(n, o);
+    // The window is marked closed right after this, so check once that has happened
+    if (window == m_item)
+        QMetaObject::invokeMethod(this, "releaseWindow", Qt::QueuedConnection);
+}
 
-    if (m_shaderEffect) m_shaderEffect->setSize(n.size());
+void WindowPixmapItem::releaseWindow()
+{
+    // A closed window that is only shown through its thumbnail is not needed
+    // anymore; dropping the reference lets the compositor delete it and its buffers
+    if (!m_item || !m_item->m_downgraded || !m_item->m_windowClosed || m_thumbnail.isNull())
+        return;
+
+    detachItem();
+}
+
+void WindowPixmapItem::detachItem()
+{
+    QObject::disconnect(m_item, SIGNAL(downgradedChanged()), this, SLOT(update()));
+    m_item->m_covers.removeOne(this);
+    m_item->imageRelease();
+    m_item = 0;
 }
 
 void WindowPixmapItem::updateItem()
@@ -354,23 +752,17 @@ void WindowPixmapItem::updateItem()
     if (c && m_id) {
         LipstickCompositorWindow *w = static_cast<LipstickCompositorWindow *>(c->windowForId(m_id));
 
-        if (!w) {
-            delete m_shaderEffect;
-            m_shaderEffect = 0;
+        if (!w)
             return;
-        } else if (w->surface()) {
-            m_item = w;
-            delete m_shaderEffect; m_shaderEffect = 0;
-        } else {
-            if (!m_shaderEffect) {
-                m_shaderEffect = static_cast<QQuickItem *>(c->shaderEffectComponent()->create());
-                Q_ASSERT(m_shaderEffect);
-                m_shaderEffect->setParentItem(this);
-                m_shaderEffect->setSize(QSizeF(width(), height()));
-            }
-
-            m_shaderEffect->setProperty("window", qVariantFromValue((QObject *)w));
-        }
+
+        m_item = w;
+        w->m_covers.append(this);
+        // A new cover gets one fresh frame whatever its policy
+        w->m_coverRefreshPending = true;
+        QObject::connect(w, SIGNAL(downgradedChanged()), this, SLOT(update()));
+
+        if (w->isInProcess())
+            static_cast<LipstickCompositorProcWindow *>(w)->layerAddref();
 
         w->imageAddref();
 
@@ -17,6 +17,7 @@
 #define WINDOWPIXMAPITEM_H
 
 #include <QQuickItem>
+#include <QImage>
 #include "lipstickglobal.h"
 
 class LipstickCompositor;
@@ -25,10 +26,24 @@ class LIPSTICK_EXPORT WindowPixmapItem : public QQuickItem
 {
     Q_OBJECT
     Q_PROPERTY(int windowId READ windowId WRITE setWindowId NOTIFY windowIdChanged)
-    Q_PROPERTY(bool opaque READ opaque WRITE setOpaque NOTIFY opaqueChanged)
+    Q_PROPERTY(bool opaque READ opaque WRITE setOpaque RESET resetOpaque NOTIFY opaqueChanged)
     Q_PROPERTY(qreal radius READ radius WRITE setRadius NOTIFY radiusChanged)
+    Q_PROPERTY(qreal topLeftRadius READ topLeftRadius WRITE setTopLeftRadius NOTIFY topLeftRadiusChanged)
+    Q_PROPERTY(qreal topRightRadius READ topRightRadius WRITE setTopRightRadius NOTIFY topRightRadiusChanged)
+    Q_PROPERTY(qreal bottomRightRadius READ bottomRightRadius WRITE setBottomRightRadius NOTIFY bottomRightRadiusChanged)
+    Q_PROPERTY(qreal bottomLeftRadius READ bottomLeftRadius WRITE setBottomLeftRadius NOTIFY bottomLeftRadiusChanged)
+    Q_PROPERTY(UpdatePolicy updatePolicy READ updatePolicy WRITE setUpdatePolicy NOTIFY updatePolicyChanged)
+    Q_PROPERTY(int updateRate READ updateRate WRITE setUpdateRate NOTIFY updateRateChanged)
+    Q_ENUMS(UpdatePolicy)
 
 public:
+    enum UpdatePolicy {
+        Live,
+        Throttled,
+        OnActivate,
+        Frozen
+    };
+
     WindowPixmapItem();
     ~WindowPixmapItem();
 
@@ -37,27 +52,66 @@ public:
 
     bool opaque() const;
     void setOpaque(bool);
+    void resetOpaque();
 
     qreal radius() const;
     void setRadius(qreal);
 
+    qreal topLeftRadius() const;
+    void setTopLeftRadius(qreal);
+
+    qreal topRightRadius() const;
+    void setTopRightRadius(qreal);
+
+    qreal bottomRightRadius() const;
+    void setBottomRightRadius(qreal);
+
+    qreal bottomLeftRadius() const;
+    void setBottomLeftRadius(qreal);
+
+    UpdatePolicy updatePolicy() const;
+    void setUpdatePolicy(UpdatePolicy);
+
+    int updateRate() const;
+    void setUpdateRate(int);
+
 protected:
     QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *);
-    virtual void geometryChanged(const QRectF &, const QRectF &);
 
 signals:
     void windowIdChanged();
     void opaqueChanged();
     void radiusChanged();
+    void topLeftRadiusChanged();
+    void topRightRadiusChanged();
+    void bottomRightRadiusChanged();
+    void bottomLeftRadiusChanged();
+    void updatePolicyChanged();
+    void updateRateChanged();
+
+private slots:
+    void windowRemoved(QObject *);
+    void releaseWindow();
 
 private:
+    friend class LipstickCompositorWindow;
     void updateItem();
+    void detachItem();
+    void updateThrottling();
 
     LipstickCompositorWindow *m_item;
-    QQuickItem *m_shaderEffect;
     int m_id;
     bool m_opaque;
+    bool m_opaqueSet;
+    bool m_textureOpaque;
     qreal m_radius;
+    qreal m_topLeftRadius;
+    qreal m_topRightRadius;
+    qreal m_bottomRightRadius;
+    qreal m_bottomLeftRadius;
+    UpdatePolicy m_updatePolicy;
+    int m_updateRate;
+    QImage m_thumbnail;
 };
 
 #endif // WINDOWPIXMAPITEM_H
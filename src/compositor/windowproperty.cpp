@@ -18,13 +18,20 @@
 #include "lipstickcompositor.h"
 
 WindowProperty::WindowProperty()
-: m_windowId(0), m_waitingRefProperty(false)
+: m_windowId(0), m_isLink(false), m_link(0), m_linkProcessId(0), m_linkedWindowId(0)
 {
     LipstickCompositor *c = LipstickCompositor::instance();
     if (!c)
         qWarning("WindowProperty: Compositor must be created before WindowProperty");
 }
 
+WindowProperty::~WindowProperty()
+{
+    LipstickCompositor *c = LipstickCompositor::instance();
+    if (c)
+        c->releaseWindowLink(this);
+}
+
 int WindowProperty::windowId() const
 {
     return m_windowId;
@@ -39,9 +46,9 @@ void WindowProperty::setWindowId(int window)
 
     if (m_surface) {
         QObject::disconnect(m_surface, SIGNAL(windowPropertyChanged(QString,QVariant)), 
-                            this, SLOT(windowPropertyChanged(QString)));
+                            this, SLOT(windowPropertyChanged(QString,QVariant)));
         QObject::disconnect(m_surface, SIGNAL(destroyed(QObject *)),
-                            this, SIGNAL(valueChanged()));
+                            this, SLOT(surfaceDestroyed()));
         m_surface = 0;
     }
 
@@ -50,21 +57,71 @@ void WindowProperty::setWindowId(int window)
 
     if (m_surface) {
         QObject::connect(m_surface, SIGNAL(windowPropertyChanged(QString,QVariant)), 
-                         this, SLOT(windowPropertyChanged(QString)));
+                         this, SLOT(windowPropertyChanged(QString,QVariant)));
         QObject::connect(m_surface, SIGNAL(destroyed(QObject *)),
-                         this, SIGNAL(valueChanged()));
+                         this, SLOT(surfaceDestroyed()));
     }
     
-    disconnectRef();
+    refreshValue();
 
     emit windowIdChanged();
     emit valueChanged();
 }
 
-void WindowProperty::windowPropertyChanged(const QString &name)
+void WindowProperty::windowPropertyChanged(const QString &name, const QVariant &value)
 {
-    if (name == m_property)
+    if (name == m_property) {
+        m_value = value;
+        refreshLink();
         emit valueChanged();
+    }
+}
+
+void WindowProperty::surfaceDestroyed()
+{
+    m_value = QVariant();
+    refreshLink();
+    emit valueChanged();
+}
+
+void WindowProperty::refreshValue()
+{
+    // Only copy the surface's property map when the window or property being
+    // tracked changes, updates arrive with the change signal
+    if (m_surface && !m_property.isEmpty())
+        m_value = m_surface->windowProperties().value(m_property);
+    else
+        m_value = QVariant();
+
+    refreshLink();
+}
+
+void WindowProperty::refreshLink()
+{
+    LipstickCompositor *c = LipstickCompositor::instance();
+    if (c)
+        c->releaseWindowLink(this);
+
+    m_isLink = m_surface && m_value.type() == QVariant::String &&
+               m_value.toString().startsWith(QLatin1String("__winref:"));
+    m_link = m_isLink ? m_value.toString().mid(9).toUInt() : 0;
+    m_linkProcessId = m_link ? m_surface->processId() : 0;
+    m_linkedWindowId = 0;
+
+    // Unresolved links are parked in the compositor under (pid, WINID) and
+    // only woken by the window that matches them
+    if (c && m_link)
+        m_linkedWindowId = c->acquireWindowLink(this);
+}
+
+void WindowProperty::setLinkedWindowId(int id)
+{
+    // Called by the compositor when the linked window is mapped or goes away
+    if (m_linkedWindowId == id)
+        return;
+
+    m_linkedWindowId = id;
+    emit valueChanged();
 }
 
 QString WindowProperty::property() const
@@ -78,61 +135,18 @@ void WindowProperty::setProperty(const QString &p)
         return;
     
     m_property = p;
+    refreshValue();
     emit propertyChanged();
     emit valueChanged();
 }
 
-void WindowProperty::connectRef()
-{
-    LipstickCompositor *c = LipstickCompositor::instance();
-    if (c && !m_waitingRefProperty) {
-        m_waitingRefProperty = true;
-        QObject::connect(c, SIGNAL(availableWinIdsChanged()), this, SLOT(availableWinIdsChanged()));
-    }
-}
-
-void WindowProperty::disconnectRef()
-{
-    LipstickCompositor *c = LipstickCompositor::instance();
-    if (c && m_waitingRefProperty) {
-        m_waitingRefProperty = false;
-        QObject::disconnect(c, SIGNAL(availableWinIdsChanged()), this, SLOT(availableWinIdsChanged()));
-    }
-}
-
 QVariant WindowProperty::value()
 {
     if (!m_surface)
         return QVariant();
 
-
-    QVariant rv = m_surface->windowProperties().value(m_property);
-    if (rv.type() == QVariant::String && rv.toString().startsWith("__winref:")) {
-        QString refId = rv.toString().mid(9);
-        uint id = refId.toUInt();
-
-        if (id) {
-            int win = LipstickCompositor::instance()->windowIdForLink(m_surface, id);
-            if (win == 0)
-                connectRef();
-            else
-                disconnectRef();
-
-            return QVariant(win);
-        } else {
-            disconnectRef();
-
-            return QVariant(0);
-        }
-    } else {
-        disconnectRef();
-
-        return rv;
-    }
-}
-
-void WindowProperty::availableWinIdsChanged()
-{
-    if (value().isValid())
-        emit valueChanged();
+    if (m_isLink)
+        return QVariant(m_linkedWindowId);
+    else
+        return m_value;
 }
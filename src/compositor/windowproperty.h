@@ -31,6 +31,7 @@ class LIPSTICK_EXPORT WindowProperty : public QObject
     Q_PROPERTY(QVariant value READ value NOTIFY valueChanged)
 public:
     WindowProperty();
+    ~WindowProperty();
 
     int windowId() const;
     void setWindowId(int);
@@ -46,15 +47,23 @@ signals:
     void valueChanged();
 
 private slots:
-    void availableWinIdsChanged();
-    void windowPropertyChanged(const QString &);
+    void windowPropertyChanged(const QString &, const QVariant &);
+    void surfaceDestroyed();
 
 private:
+    friend class LipstickCompositor;
+
+    void refreshValue();
+    void refreshLink();
+    void setLinkedWindowId(int);
+
     int m_windowId;
-    bool m_waitingRefProperty;
-    void connectRef();
-    void disconnectRef();
+    bool m_isLink;
+    uint m_link;
+    qint64 m_linkProcessId;
+    int m_linkedWindowId;
     QString m_property;
+    QVariant m_value;
     QPointer<QWaylandSurface> m_surface;
 };
 
@@ -131,7 +131,7 @@ HomeApplication::HomeApplication(int &argc, char **argv, const QString &qmlPath)
         qWarning("Unable to register shutdown object at path %s: %s", SHUTDOWN_DBUS_PATH, systemBus.lastError().message().toUtf8().constData());
     }
 
-    ScreenshotService *screenshotService = new ScreenshotService(this);
+    ScreenshotService *screenshotService = new ScreenshotService(deviceLock, this);
     new ScreenshotServiceAdaptor(screenshotService);
     QDBusConnection sessionBus = QDBusConnection::sessionBus();
     static const char *SCREENSHOT_DBUS_PATH = "/org/nemomobile/lipstick/screenshot";
@@ -301,12 +301,12 @@ void HomeApplication::setUpdatesEnabled(bool enabled)
         updatesEnabled = enabled;
 
         if (!updatesEnabled) {
-            LipstickCompositor::instance()->hide();
+            LipstickCompositor::instance()->setUpdatesEnabled(false);
             QGuiApplication::platformNativeInterface()->nativeResourceForIntegration("DisplayOff");
         } else {
             QGuiApplication::platformNativeInterface()->nativeResourceForIntegration("DisplayOn");
             emit LipstickCompositor::instance()->displayAboutToBeOn();
-            LipstickCompositor::instance()->showFullScreen();
+            LipstickCompositor::instance()->setUpdatesEnabled(true);
         }
     }
 }
@@ -113,6 +113,24 @@ signals:
      */
     void homeReady();
 
+    /*!
+     * Emitted when the compositor has terminated a background application to free memory.
+     *
+     * \param pid the process id of the application
+     * \param executable the executable of the application
+     * \param reason a human readable description of why the application was terminated
+     */
+    void applicationReaped(qint64 pid, const QString &executable, const QString &reason);
+
+    /*!
+     * Emitted when an application launched from the launcher is on screen.
+     *
+     * \param desktopFile the file name of the application's desktop entry
+     * \param cold \c true if a new window was mapped, \c false if a running one was raised
+     * \param milliseconds the time from launching to the first frame showing the window
+     */
+    void applicationLaunched(const QString &desktopFile, bool cold, int milliseconds);
+
     /*
      * Emitted before the HomeApplication commences destruction.
      */
@@ -14,7 +14,6 @@
 ****************************************************************************/
 
 #include <NgfClient>
-#include <QWaylandSurface>
 #include <QDBusMessage>
 #include <QDBusConnection>
 #include <QDBusPendingCall>
@@ -85,11 +84,8 @@ void NotificationFeedbackPlayer::removeNotification(uint id)
 
 bool NotificationFeedbackPlayer::isEnabled(LipstickNotification *notification)
 {
-    uint mode = AllNotificationsEnabled;
-    QWaylandSurface *surface = LipstickCompositor::instance()->surfaceForId(LipstickCompositor::instance()->topmostWindowId());
-    if (surface != 0) {
-        mode = surface->windowProperties().value("NOTIFICATION_PREVIEWS_DISABLED", uint(AllNotificationsEnabled)).toUInt();
-    }
+    LipstickCompositor *compositor = LipstickCompositor::instance();
+    uint mode = compositor->windowNotificationPreviewsDisabled(compositor->topmostWindowId());
 
     return mode == AllNotificationsEnabled ||
            (mode == ApplicationNotificationsDisabled && notification->hints().value(NotificationManager::HINT_URGENCY).toInt() >= 2) ||
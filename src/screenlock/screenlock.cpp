@@ -25,19 +25,20 @@
 #include "homeapplication.h"
 #include "screenlock.h"
 #include "utilities/closeeventeater.h"
+#include "utilities/inputrouter.h"
 
 ScreenLock::ScreenLock(QObject* parent) :
     QObject(parent),
     callbackInterface(NULL),
     shuttingDown(false),
-    lockscreenVisible(false),
-    eatEvents(false)
+    lockscreenVisible(false)
 {
-    qApp->installEventFilter(this);
+    connect(InputRouter::instance(), SIGNAL(eventEaten()), this, SLOT(hideEventEater()));
 }
 
 ScreenLock::~ScreenLock()
 {
+    InputRouter::instance()->setEatingEvents(false);
 }
 
 int ScreenLock::tklock_open(const QString &service, const QString &path, const QString &interface, const QString &method, uint mode, bool, bool)
@@ -161,21 +162,10 @@ void ScreenLock::toggleScreenLockUI(bool toggle)
 
 void ScreenLock::toggleEventEater(bool toggle)
 {
-    eatEvents = toggle;
+    InputRouter::instance()->setEatingEvents(toggle);
 }
 
 bool ScreenLock::isScreenLocked() const
 {
     return lockscreenVisible;
 }
-
-bool ScreenLock::eventFilter(QObject *, QEvent *event)
-{
-    bool eat = eatEvents && (event->type() == QEvent::MouseButtonPress || event->type() == QEvent::TouchBegin || event->type() == QEvent::TouchUpdate || event->type() == QEvent::TouchEnd);
-
-    if (eat) {
-        hideEventEater();
-    }
-
-    return eat;
-}
@@ -69,10 +69,6 @@ public:
      */
     bool isScreenLocked() const;
 
-    //! \reimp
-    virtual bool eventFilter(QObject *, QEvent *event);
-    //! \reimp_end
-
 public slots:
     //! Shows the screen lock window and calls the MCE's lock function.
     void lockScreen(bool immediate = false);
@@ -148,9 +144,6 @@ private:
     //! Whether the lockscreen is visible or not
     bool lockscreenVisible;
 
-    //! Whether events should be eaten or not
-    bool eatEvents;
-
 #ifdef UNIT_TEST
     friend class Ut_ScreenLock;
 #endif
@@ -14,17 +14,200 @@
 ****************************************************************************/
 #include <QStandardPaths>
 #include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <QRunnable>
+#include <QThreadPool>
 #include "lipstickcompositor.h"
+#include "framecapturebuffer.h"
+#include "devicelock/devicelock.h"
 #include "screenshotservice.h"
 
-ScreenshotService::ScreenshotService(QObject *parent) :
-    QObject(parent)
+namespace {
+
+class ScreenshotWriter : public QRunnable
+{
+public:
+    ScreenshotWriter(QObject *receiver, const QImage &image, bool readBack, const QRect &region, qreal scale,
+                     const QString &path, const QByteArray &format, int quality) :
+        receiver(receiver), image(image), readBack(readBack), region(region), scale(scale),
+        path(path), format(format), quality(quality)
+    {
+    }
+
+    void run()
+    {
+        QImage result = image;
+        if (readBack) {
+            // The rows were read bottom-up as GL_RGBA
+            result = result.rgbSwapped().mirrored();
+        } else if (!region.isEmpty()) {
+            result = result.copy(region);
+        }
+
+        // The frame buffer alpha is whatever the scene left there, not coverage
+        result = result.convertToFormat(QImage::Format_RGB32);
+
+        if (scale > 0 && scale != 1) {
+            result = result.scaled(result.size() * scale, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        }
+
+        QImageWriter writer(path, format);
+        writer.setQuality(quality);
+        bool success = !result.isNull() && writer.write(result);
+        if (!success) {
+            qWarning() << "Could not save screenshot to" << path << writer.errorString();
+        }
+
+        QMetaObject::invokeMethod(receiver, "encodingFinished", Qt::QueuedConnection, Q_ARG(QString, path), Q_ARG(bool, success));
+    }
+
+private:
+    QObject *receiver;
+    QImage image;
+    bool readBack;
+    QRect region;
+    qreal scale;
+    QString path;
+    QByteArray format;
+    int quality;
+};
+
+}
+
+ScreenshotService::ScreenshotService(DeviceLock *deviceLock, QObject *parent) :
+    QObject(parent),
+    deviceLock(deviceLock)
+{
+    frameCaptureWatcher.setConnection(QDBusConnection::sessionBus());
+    frameCaptureWatcher.setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
+    connect(&frameCaptureWatcher, SIGNAL(serviceUnregistered(QString)), this, SLOT(stopFrameCapture()));
+    if (deviceLock != 0) {
+        connect(deviceLock, SIGNAL(stateChanged(int)), this, SLOT(deviceLockStateChanged(int)));
+    }
+}
+
+ScreenshotService::~ScreenshotService()
 {
+    stopFrameCapture();
 }
 
 void ScreenshotService::saveScreenshot(const QString &path)
 {
+    captureScreenshot(path, QVariantMap());
+}
+
+QString ScreenshotService::captureScreenshot(const QString &path, const QVariantMap &options)
+{
+    Request request;
+    request.format = options.value("format").toString().toLatin1().toLower();
+    if (request.format.isEmpty()) {
+        request.format = QFileInfo(path).suffix().toLatin1().toLower();
+    }
+    if (request.format.isEmpty()) {
+        request.format = "png";
+    }
+    request.path = path.isEmpty() ? (QStandardPaths::writableLocation(QStandardPaths::PicturesLocation) + "/" + QDateTime::currentDateTime().toString("yyyyMMddhhmmss") + "." + request.format) : path;
+    request.quality = options.value("quality", -1).toInt();
+    request.region = QRect(options.value("x").toInt(), options.value("y").toInt(), options.value("width").toInt(), options.value("height").toInt());
+    request.scale = options.value("scale", 1.0).toReal();
+    request.readBack = true;
+
+    LipstickCompositor *compositor = LipstickCompositor::instance();
+    if (compositor == 0) {
+        QMetaObject::invokeMethod(this, "encodingFinished", Qt::QueuedConnection, Q_ARG(QString, request.path), Q_ARG(bool, false));
+        return request.path;
+    }
+
+    QRect region = request.region.isEmpty() ? QRect(QPoint(), compositor->size()) : request.region;
+    int id = compositor->requestFrameGrab(region);
+    if (id < 0) {
+        // Nothing is being rendered; grab synchronously, which costs no frames either
+        request.readBack = false;
+        qreal ratio = compositor->devicePixelRatio();
+        request.region = QRect(request.region.topLeft() * ratio, request.region.size() * ratio);
+        encode(request, compositor->grabWindow());
+    } else {
+        if (requests.isEmpty()) {
+            connect(compositor, SIGNAL(frameGrabbed(int,QImage)), this, SLOT(frameGrabbed(int,QImage)), Qt::QueuedConnection);
+        }
+        requests.insert(id, request);
+    }
+
+    return request.path;
+}
+
+void ScreenshotService::frameGrabbed(int id, const QImage &image)
+{
+    if (!requests.contains(id)) {
+        return;
+    }
+
+    encode(requests.take(id), image);
+
+    if (requests.isEmpty()) {
+        disconnect(LipstickCompositor::instance(), SIGNAL(frameGrabbed(int,QImage)), this, SLOT(frameGrabbed(int,QImage)));
+    }
+}
+
+void ScreenshotService::encode(const Request &request, const QImage &image)
+{
+    QThreadPool::globalInstance()->start(new ScreenshotWriter(this, image, request.readBack, request.region,
+                                                              request.scale, request.path, request.format, request.quality));
+}
+
+void ScreenshotService::encodingFinished(const QString &path, bool success)
+{
+    emit screenshotSaved(path, success);
+}
+
+QDBusUnixFileDescriptor ScreenshotService::startFrameCapture(const QVariantMap &options)
+{
+    stopFrameCapture();
+
+    LipstickCompositor *compositor = LipstickCompositor::instance();
+    if (compositor == 0 || !calledFromDBus()) {
+        return QDBusUnixFileDescriptor();
+    }
+
+    if (deviceLock != 0 && deviceLock->state() == DeviceLock::Locked) {
+        sendErrorReply(QDBusError::AccessDenied, "The device is locked");
+        return QDBusUnixFileDescriptor();
+    }
+
+    FrameCaptureBuffer *buffer = new FrameCaptureBuffer(compositor->size() * compositor->devicePixelRatio(),
+                                                        options.value("scale", 1.0).toReal(),
+                                                        options.value("maxRate", 0.0).toReal(),
+                                                        options.value("slots", 3).toInt());
+    if (!buffer->isValid()) {
+        delete buffer;
+        return QDBusUnixFileDescriptor();
+    }
+
+    // The descriptor is duplicated into the reply before the buffer can go away
+    QDBusUnixFileDescriptor fd(buffer->fileDescriptor());
+    compositor->setFrameCapture(buffer);
+    frameCaptureWatcher.addWatchedService(message().service());
+
+    return fd;
+}
+
+void ScreenshotService::stopFrameCapture()
+{
+    if (frameCaptureWatcher.watchedServices().isEmpty()) {
+        return;
+    }
+
+    frameCaptureWatcher.setWatchedServices(QStringList());
     if (LipstickCompositor::instance() != 0) {
-        LipstickCompositor::instance()->grabWindow().save(path.isEmpty() ? (QStandardPaths::writableLocation(QStandardPaths::PicturesLocation) + "/" + QDateTime::currentDateTime().toString("yyyyMMddhhmmss") + ".png") : path);
+        LipstickCompositor::instance()->setFrameCapture(0);
+    }
+}
+
+void ScreenshotService::deviceLockStateChanged(int state)
+{
+    if (state == DeviceLock::Locked) {
+        stopFrameCapture();
     }
 }
@@ -16,15 +16,102 @@
 #define SCREENSHOTSERVICE_H
 
 #include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QRect>
+#include <QVariantMap>
+#include <QDBusUnixFileDescriptor>
+#include <QDBusContext>
+#include <QDBusServiceWatcher>
 
-class ScreenshotService : public QObject
+class DeviceLock;
+
+class ScreenshotService : public QObject, protected QDBusContext
 {
     Q_OBJECT
 public:
-    explicit ScreenshotService(QObject *parent = 0);
+    /*!
+     * Creates a screenshot service.
+     *
+     * \param deviceLock the device lock; frames are not captured while it is locked
+     * \param parent the parent object
+     */
+    explicit ScreenshotService(DeviceLock *deviceLock, QObject *parent = 0);
+    ~ScreenshotService();
 
 public slots:
+    /*!
+     * Saves a screenshot of the next frame as PNG. Returns immediately;
+     * screenshotSaved() is emitted when the file has been written.
+     *
+     * \param path the file to write or an empty string for a default path
+     */
     void saveScreenshot(const QString &path);
+
+    /*!
+     * Saves a screenshot of the next frame. The frame is read back on the
+     * render thread and encoded on a worker thread. Returns immediately;
+     * screenshotSaved() is emitted when the file has been written.
+     *
+     * Supported options: "format" (image format, by default from the path or
+     * "png"), "quality" (0-100), "x", "y", "width" and "height" (region of
+     * the screen) and "scale" (factor applied to the region).
+     *
+     * \param path the file to write or an empty string for a default path
+     * \param options the capture options
+     * \return the path the screenshot is written to
+     */
+    QString captureScreenshot(const QString &path, const QVariantMap &options);
+
+    /*!
+     * Starts publishing every rendered frame into a ring buffer in shared
+     * memory, replacing any capture already running. The layout of the
+     * buffer is described in framecapturebuffer.h. The capture stops when
+     * the calling D-Bus client leaves the bus or the device gets locked,
+     * and is refused while the device is locked.
+     *
+     * Supported options: "scale" (factor applied to the frames, at most 1),
+     * "maxRate" (frames per second, unlimited by default) and "slots"
+     * (number of frames in the ring, 3 by default).
+     *
+     * \param options the capture options
+     * \return a file descriptor of the shared memory, invalid on failure
+     */
+    QDBusUnixFileDescriptor startFrameCapture(const QVariantMap &options);
+
+    //! Stops publishing frames
+    void stopFrameCapture();
+
+signals:
+    /*!
+     * Sent when a screenshot has been written or has failed.
+     *
+     * \param path the path of the screenshot
+     * \param success \c true if the screenshot was written, \c false otherwise
+     */
+    void screenshotSaved(const QString &path, bool success);
+
+private slots:
+    void frameGrabbed(int request, const QImage &image);
+    void encodingFinished(const QString &path, bool success);
+    void deviceLockStateChanged(int state);
+
+private:
+    struct Request {
+        QString path;
+        QByteArray format;
+        int quality;
+        QRect region;
+        qreal scale;
+        bool readBack;
+    };
+
+    void encode(const Request &request, const QImage &image);
+
+    QHash<int, Request> requests;
+    DeviceLock *deviceLock;
+    //! Watches the client of the frame capture, which is running while it is watched
+    QDBusServiceWatcher frameCaptureWatcher;
 };
 
 #endif // SCREENSHOTSERVICE_H
@@ -27,6 +27,7 @@ include(compositor/compositor.pri)
 PUBLICHEADERS += \
     utilities/qobjectlistmodel.h \
     utilities/closeeventeater.h \
+    utilities/inputrouter.h \
     homeapplication.h \
     homewindow.h \
     lipstickglobal.h \
@@ -66,7 +67,9 @@ HEADERS += \
     homeapplicationadaptor.h \
     shutdownscreenadaptor.h \
     screenshotservice.h \
-    screenshotserviceadaptor.h
+    screenshotserviceadaptor.h \
+    components/launchtracker.h \
+    components/desktopentrycache.h
 
 SOURCES += \
     homeapplication.cpp \
@@ -75,9 +78,12 @@ SOURCES += \
     lipsticksettings.cpp \
     utilities/qobjectlistmodel.cpp \
     utilities/closeeventeater.cpp \
+    utilities/inputrouter.cpp \
     components/launcheritem.cpp \
     components/launchermodel.cpp \
     components/launchermonitor.cpp \
+    components/launchtracker.cpp \
+    components/desktopentrycache.cpp \
     notifications/notificationmanager.cpp \
     notifications/notificationmanageradaptor.cpp \
     notifications/lipsticknotification.cpp \
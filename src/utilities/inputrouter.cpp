@@ -0,0 +1,116 @@
+/***************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd.
+**
+** This file is part of lipstick.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include <QCoreApplication>
+#include <QKeyEvent>
+#include "inputrouter.h"
+
+InputRouter *InputRouter::instance_ = 0;
+
+InputRouter *InputRouter::instance()
+{
+    if (instance_ == 0) {
+        instance_ = new InputRouter(qApp);
+    }
+    return instance_;
+}
+
+InputRouter::InputRouter(QObject *parent) :
+    QObject(parent),
+    volumeKeyHandler_(0),
+    eatEvents(false),
+    filterInstalled(false)
+{
+}
+
+void InputRouter::setGrabbedKeys(KeyHandler *handler, const QList<int> &keys)
+{
+    foreach (int key, grabbedKeys.value(handler)) {
+        keyHandlers.remove(key, handler);
+    }
+
+    if (keys.isEmpty()) {
+        grabbedKeys.remove(handler);
+    } else {
+        grabbedKeys.insert(handler, keys);
+        foreach (int key, keys) {
+            keyHandlers.insertMulti(key, handler);
+        }
+    }
+
+    updateEventFilter();
+}
+
+void InputRouter::setVolumeKeyHandler(KeyHandler *handler)
+{
+    volumeKeyHandler_ = handler;
+    updateEventFilter();
+}
+
+InputRouter::KeyHandler *InputRouter::volumeKeyHandler() const
+{
+    return volumeKeyHandler_;
+}
+
+void InputRouter::setEatingEvents(bool eat)
+{
+    eatEvents = eat;
+    updateEventFilter();
+}
+
+bool InputRouter::isEatingEvents() const
+{
+    return eatEvents;
+}
+
+void InputRouter::updateEventFilter()
+{
+    bool install = eatEvents || volumeKeyHandler_ != 0 || !keyHandlers.isEmpty();
+    if (install == filterInstalled) {
+        return;
+    }
+
+    if (install) {
+        qApp->installEventFilter(this);
+    } else {
+        qApp->removeEventFilter(this);
+    }
+    filterInstalled = install;
+}
+
+bool InputRouter::eventFilter(QObject *, QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease: {
+        QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
+        KeyHandler *handler = keyHandlers.value(keyEvent->key(), 0);
+        if (handler == 0 && (keyEvent->key() == Qt::Key_VolumeUp || keyEvent->key() == Qt::Key_VolumeDown)) {
+            handler = volumeKeyHandler_;
+        }
+        return handler != 0 && handler->handleKeyEvent(keyEvent);
+    }
+    case QEvent::MouseButtonPress:
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::TouchEnd:
+        if (eatEvents) {
+            emit eventEaten();
+            return true;
+        }
+        return false;
+    default:
+        return false;
+    }
+}
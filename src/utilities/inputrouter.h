@@ -0,0 +1,110 @@
+/***************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd.
+**
+** This file is part of lipstick.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef INPUTROUTER_H_
+#define INPUTROUTER_H_
+
+#include <QObject>
+#include <QMultiHash>
+#include "lipstickglobal.h"
+
+class QKeyEvent;
+
+/*!
+ * The input router is the only application wide event filter of lipstick.
+ * It delivers grabbed keys to their owners, volume keys to the volume key
+ * handler and eats pointer events while the event eater is enabled. It is
+ * only installed while any of these is in use, so that other events do not
+ * go through it at all.
+ */
+class LIPSTICK_EXPORT InputRouter : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! Receiver of the key events routed to it
+    class KeyHandler
+    {
+    public:
+        virtual ~KeyHandler() {}
+
+        /*!
+         * Handles a key press or release routed to this handler.
+         *
+         * \param event the key event
+         * \return \c true if the event was consumed, \c false otherwise
+         */
+        virtual bool handleKeyEvent(QKeyEvent *event) = 0;
+    };
+
+    //! Returns the input router instance
+    static InputRouter *instance();
+
+    /*!
+     * Sets the keys grabbed by a handler, replacing any it grabbed earlier.
+     * If several handlers grab the same key, the one that grabbed it last
+     * receives it.
+     *
+     * \param handler the handler receiving the keys
+     * \param keys the grabbed keys; empty to release all of them
+     */
+    void setGrabbedKeys(KeyHandler *handler, const QList<int> &keys);
+
+    /*!
+     * Sets the handler for the volume keys, used when no handler has grabbed them.
+     *
+     * \param handler the volume key handler or \c NULL to unset it
+     */
+    void setVolumeKeyHandler(KeyHandler *handler);
+
+    //! Returns the volume key handler
+    KeyHandler *volumeKeyHandler() const;
+
+    /*!
+     * Enables or disables the event eater. While it is enabled the next
+     * mouse press or touch event is eaten and eventEaten() is emitted.
+     *
+     * \param eat \c true to enable the event eater, \c false to disable it
+     */
+    void setEatingEvents(bool eat);
+
+    //! Returns whether the event eater is enabled
+    bool isEatingEvents() const;
+
+    //! \reimp
+    virtual bool eventFilter(QObject *, QEvent *event);
+    //! \reimp_end
+
+signals:
+    //! Emitted when the event eater has eaten an event
+    void eventEaten();
+
+private:
+    explicit InputRouter(QObject *parent = 0);
+    void updateEventFilter();
+
+    static InputRouter *instance_;
+
+    QMultiHash<int, KeyHandler *> keyHandlers;
+    QHash<KeyHandler *, QList<int> > grabbedKeys;
+    KeyHandler *volumeKeyHandler_;
+    bool eatEvents;
+    bool filterInstalled;
+
+#ifdef UNIT_TEST
+    friend class Ut_InputRouter;
+#endif
+};
+
+#endif /* INPUTROUTER_H_ */
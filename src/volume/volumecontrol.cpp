@@ -22,6 +22,7 @@
 #include <QScreen>
 #include <QKeyEvent>
 #include <MGConfItem>
+#include <qmdisplaystate.h>
 #include "utilities/closeeventeater.h"
 #include "pulseaudiocontrol.h"
 #include "volumecontrol.h"
@@ -32,6 +33,7 @@ VolumeControl::VolumeControl(QObject *parent) :
     pulseAudioControl(new PulseAudioControl(this)),
     hwKeyResource(new ResourcePolicy::ResourceSet("event")),
     hwKeysAcquired(false),
+    displayState(new MeeGo::QmDisplayState(this)),
     volume_(0),
     maximumVolume_(0),
     audioWarning(new MGConfItem("/desktop/nemo/audiowarning", this)),
@@ -41,6 +43,7 @@ VolumeControl::VolumeControl(QObject *parent) :
     hwKeyResource->addResourceObject(new ResourcePolicy::ScaleButtonResource);
     connect(hwKeyResource, SIGNAL(resourcesGranted(QList<ResourcePolicy::ResourceType>)), this, SLOT(hwKeyResourceAcquired()));
     connect(hwKeyResource, SIGNAL(lostResources()), this, SLOT(hwKeyResourceLost()));
+    connect(displayState, SIGNAL(displayStateChanged(MeeGo::QmDisplayState::DisplayState)), this, SLOT(updateVolumeKeyHandler()));
 
     // Set up key repeat: initial delay and per-repeat delay
     keyReleaseTimer.setSingleShot(true);
@@ -57,13 +60,14 @@ VolumeControl::VolumeControl(QObject *parent) :
     connect(pulseAudioControl, SIGNAL(longListeningTime(int)), SLOT(handleLongListeningTime(int)));
     pulseAudioControl->update();
 
-    qApp->installEventFilter(this);
-
     acquireKeys();
 }
 
 VolumeControl::~VolumeControl()
 {
+    if (InputRouter::instance()->volumeKeyHandler() == this) {
+        InputRouter::instance()->setVolumeKeyHandler(0);
+    }
     hwKeyResource->deleteResource(ResourcePolicy::ScaleButtonType);
     delete window;
 }
@@ -156,12 +160,28 @@ void VolumeControl::setVolume(int volume, int maximumVolume)
 void VolumeControl::hwKeyResourceAcquired()
 {
     hwKeysAcquired = true;
+    updateVolumeKeyHandler();
 }
 
 void VolumeControl::hwKeyResourceLost()
 {
     hwKeysAcquired = false;
-    stopKeyRepeat();
+    updateVolumeKeyHandler();
+}
+
+void VolumeControl::updateVolumeKeyHandler()
+{
+    // The resource is held nearly all the time, so being the volume key
+    // handler only while the display is on keeps the application wide input
+    // filter uninstalled while the device sits idle with the display off
+    if (hwKeysAcquired && displayState->get() != MeeGo::QmDisplayState::Off) {
+        InputRouter::instance()->setVolumeKeyHandler(this);
+    } else {
+        if (InputRouter::instance()->volumeKeyHandler() == this) {
+            InputRouter::instance()->setVolumeKeyHandler(0);
+        }
+        stopKeyRepeat();
+    }
 }
 
 void VolumeControl::releaseKeys()
@@ -217,12 +237,11 @@ void VolumeControl::handleLongListeningTime(int listeningTime)
     emit showAudioWarning(listeningTime == 0);
 }
 
-bool VolumeControl::eventFilter(QObject *, QEvent *event)
+bool VolumeControl::handleKeyEvent(QKeyEvent *keyEvent)
 {
-    if (hwKeysAcquired && (event->type() == QEvent::KeyPress || event->type() == QEvent::KeyRelease)) {
-        QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
+    if (hwKeysAcquired) {
         if (keyEvent->key() == Qt::Key_VolumeUp || keyEvent->key() == Qt::Key_VolumeDown) {
-            if (event->type() == QEvent::KeyPress) {
+            if (keyEvent->type() == QEvent::KeyPress) {
                 // Key down: set which way to change the volume on each repeat, start the repeat delay timer and change the volume once
                 volumeChange = keyEvent->key() == Qt::Key_VolumeUp ? 1 : -1;
                 if (!keyRepeatDelayTimer.isActive() && !keyRepeatTimer.isActive()) {
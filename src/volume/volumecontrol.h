@@ -19,6 +19,7 @@
 #include <QTimer>
 #include <QObject>
 #include "lipstickglobal.h"
+#include "inputrouter.h"
 
 class HomeWindow;
 class PulseAudioControl;
@@ -29,6 +30,10 @@ namespace ResourcePolicy {
     class ResourceSet;
 }
 
+namespace MeeGo {
+    class QmDisplayState;
+}
+
 /*!
  * \class VolumeControl
  *
@@ -37,7 +42,7 @@ namespace ResourcePolicy {
  * Creates a transparent window which can be used to show
  * the current volume level.
  */
-class LIPSTICK_EXPORT VolumeControl : public QObject
+class LIPSTICK_EXPORT VolumeControl : public QObject, public InputRouter::KeyHandler
 {
     Q_OBJECT
     Q_PROPERTY(int volume READ volume NOTIFY volumeChanged)
@@ -108,7 +113,7 @@ public:
     bool warningAcknowledged() const;
 
     //! \reimp
-    virtual bool eventFilter(QObject *watched, QEvent *event);
+    virtual bool handleKeyEvent(QKeyEvent *event);
     //! \reimp_end
 
 signals:
@@ -170,6 +175,9 @@ private slots:
     //! Used to show long listening time warning
     void handleLongListeningTime(int listeningTime);
 
+    //! Routes the volume keys to this controller only while they are acquired and the display is on
+    void updateVolumeKeyHandler();
+
 private:
     //! The volume control window
     HomeWindow *window;
@@ -183,6 +191,9 @@ private:
     //! Whether to react to volume key presses
     bool hwKeysAcquired;
 
+    //! For not routing the volume keys while the display is off
+    MeeGo::QmDisplayState *displayState;
+
     //! The current volume
     int volume_;
 
@@ -0,0 +1,17 @@
+# Runs the real compositor from the lipstick library; see compositortestharness.h
+INCLUDEPATH += $$COMMONDIR $$COMPOSITORSRCDIR
+DEPENDPATH += $$COMMONDIR
+
+HEADERS += \
+    $$COMMONDIR/compositortestharness.h \
+    $$COMMONDIR/syntheticclient.h
+
+SOURCES += \
+    $$COMMONDIR/compositortestharness.cpp \
+    $$COMMONDIR/syntheticclient.cpp
+
+QT += compositor quick dbus
+DEFINES += QT_COMPOSITOR_QUICK
+CONFIG += link_pkgconfig
+PKGCONFIG += qmsystem2-qt5
+LIBS += -L$$OUT_PWD/$$SRCDIR -llipstick-qt5
@@ -0,0 +1,143 @@
+/***************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd.
+**
+** This file is part of lipstick.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QDir>
+#include <unistd.h>
+#include "lipstickcompositor.h"
+#include "lipstickcompositorwindow.h"
+#include "compositortestharness.h"
+
+void CompositorTestHarness::initEnvironment()
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+        qputenv("LIBGL_ALWAYS_SOFTWARE", "1");
+    }
+
+    if (qgetenv("XDG_RUNTIME_DIR").isEmpty()) {
+        QString runtimeDir = QDir::tempPath() + "/lipstick-tests-" + QString::number(getuid());
+        QDir().mkpath(runtimeDir);
+        qputenv("XDG_RUNTIME_DIR", runtimeDir.toLocal8Bit());
+    }
+
+    // The compositor listens on the socket named by WAYLAND_DISPLAY
+    qputenv("WAYLAND_DISPLAY", socketName().toLocal8Bit());
+}
+
+QString CompositorTestHarness::socketName()
+{
+    return QString("lipstick-test-%1").arg(getpid());
+}
+
+CompositorTestHarness::CompositorTestHarness(const QSize &size, QObject *parent)
+: QObject(parent), m_compositor(new LipstickCompositor), m_frameCount(0), m_firstFrameTime(0), m_lastFrameTime(0),
+  m_renderStartTime(0), m_renderTimeTotal(0), m_renderedFrames(0)
+{
+    m_compositor->resize(size);
+    m_compositor->componentComplete();
+    m_compositor->show();
+
+    connect(m_compositor, SIGNAL(frameSwapped()), this, SLOT(frameSwapped()), Qt::QueuedConnection);
+    connect(m_compositor, SIGNAL(beforeRendering()), this, SLOT(renderingStarted()), Qt::DirectConnection);
+    connect(m_compositor, SIGNAL(afterRendering()), this, SLOT(renderingFinished()), Qt::DirectConnection);
+    m_clock.start();
+}
+
+CompositorTestHarness::~CompositorTestHarness()
+{
+    delete m_compositor;
+}
+
+LipstickCompositorWindow *CompositorTestHarness::windowForTitle(const QString &title) const
+{
+    foreach (LipstickCompositorWindow *window, m_compositor->m_mappedSurfaces) {
+        if (window->title() == title)
+            return window;
+    }
+    return 0;
+}
+
+bool CompositorTestHarness::waitForWindowCount(int count, int timeout)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (m_compositor->windowCount() != count && timer.elapsed() < timeout)
+        QTest::qWait(1);
+    return m_compositor->windowCount() == count;
+}
+
+bool CompositorTestHarness::waitForFrames(int count, int timeout)
+{
+    int target = m_frameCount + count;
+    QElapsedTimer timer;
+    timer.start();
+    while (m_frameCount < target && timer.elapsed() < timeout)
+        QTest::qWait(1);
+    return m_frameCount >= target;
+}
+
+void CompositorTestHarness::resetFrameStatistics()
+{
+    m_frameCount = 0;
+    m_firstFrameTime = 0;
+    m_lastFrameTime = 0;
+
+    QMutexLocker locker(&m_renderTimeMutex);
+    m_renderTimeTotal = 0;
+    m_renderedFrames = 0;
+}
+
+qreal CompositorTestHarness::averageFrameInterval() const
+{
+    if (m_frameCount < 2)
+        return 0;
+    return qreal(m_lastFrameTime - m_firstFrameTime) / 1000000 / (m_frameCount - 1);
+}
+
+qreal CompositorTestHarness::averageRenderTime() const
+{
+    QMutexLocker locker(&m_renderTimeMutex);
+    if (!m_renderedFrames)
+        return 0;
+    return qreal(m_renderTimeTotal) / 1000000 / m_renderedFrames;
+}
+
+void CompositorTestHarness::frameSwapped()
+{
+    qint64 now = m_clock.nsecsElapsed();
+    if (!m_frameCount)
+        m_firstFrameTime = now;
+    m_lastFrameTime = now;
+    ++m_frameCount;
+}
+
+void CompositorTestHarness::renderingStarted()
+{
+    QMutexLocker locker(&m_renderTimeMutex);
+    m_renderStartTime = m_clock.nsecsElapsed();
+}
+
+void CompositorTestHarness::renderingFinished()
+{
+    // The swap waits for vsync, so it is left out of the render time
+    qint64 now = m_clock.nsecsElapsed();
+
+    QMutexLocker locker(&m_renderTimeMutex);
+    if (!m_renderStartTime)
+        return;
+    m_renderTimeTotal += now - m_renderStartTime;
+    m_renderStartTime = 0;
+    ++m_renderedFrames;
+}
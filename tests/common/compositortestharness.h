@@ -0,0 +1,82 @@
+/***************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd.
+**
+** This file is part of lipstick.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef COMPOSITORTESTHARNESS_H
+#define COMPOSITORTESTHARNESS_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+
+class LipstickCompositor;
+class LipstickCompositorWindow;
+
+/*!
+ * Runs the real LipstickCompositor in the test process, on its own Wayland
+ * socket, so that synthetic clients can connect to it.
+ *
+ * initEnvironment() has to be called before the application object is
+ * created. It selects the offscreen platform and software rendering unless
+ * QT_QPA_PLATFORM is set; the platform has to provide OpenGL.
+ */
+class CompositorTestHarness : public QObject
+{
+    Q_OBJECT
+
+public:
+    static void initEnvironment();
+
+    explicit CompositorTestHarness(const QSize &size = QSize(480, 854), QObject *parent = 0);
+    ~CompositorTestHarness();
+
+    LipstickCompositor *compositor() const { return m_compositor; }
+    static QString socketName();
+
+    //! Returns the window with the given title, or 0
+    LipstickCompositorWindow *windowForTitle(const QString &title) const;
+
+    //! Waits until the compositor has the given number of windows
+    bool waitForWindowCount(int count, int timeout = 5000);
+
+    //! Waits until the given number of frames has been swapped
+    bool waitForFrames(int count, int timeout = 5000);
+
+    //! Starts counting swapped frames and the time between them
+    void resetFrameStatistics();
+    int frameCount() const { return m_frameCount; }
+    //! Average time between swapped frames since the reset, in milliseconds
+    qreal averageFrameInterval() const;
+    //! Average time from beforeRendering to afterRendering since the reset, in milliseconds
+    qreal averageRenderTime() const;
+
+private slots:
+    void frameSwapped();
+    // Called on the render thread
+    void renderingStarted();
+    void renderingFinished();
+
+private:
+    LipstickCompositor *m_compositor;
+    int m_frameCount;
+    qint64 m_firstFrameTime;
+    qint64 m_lastFrameTime;
+    mutable QMutex m_renderTimeMutex;
+    qint64 m_renderStartTime;
+    qint64 m_renderTimeTotal;
+    int m_renderedFrames;
+    QElapsedTimer m_clock;
+};
+
+#endif // COMPOSITORTESTHARNESS_H
@@ -0,0 +1,108 @@
+/***************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd.
+**
+** This file is part of lipstick.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QDebug>
+#include "syntheticclient.h"
+
+namespace {
+
+QString clientExecutable()
+{
+    QStringList candidates;
+    candidates << QString::fromLocal8Bit(qgetenv("LIPSTICK_TEST_SYNTHETIC_CLIENT"))
+               << QCoreApplication::applicationDirPath() + "/../syntheticclient/syntheticclient"
+               << QCoreApplication::applicationDirPath() + "/syntheticclient";
+
+    foreach (const QString &candidate, candidates) {
+        if (!candidate.isEmpty() && QFileInfo(candidate).isExecutable())
+            return candidate;
+    }
+    return QString();
+}
+
+}
+
+SyntheticClient::SyntheticClient(const QString &socketName, QObject *parent)
+: QObject(parent), m_socketName(socketName)
+{
+    m_process.setProcessChannelMode(QProcess::ForwardedChannels);
+}
+
+SyntheticClient::~SyntheticClient()
+{
+    if (m_process.state() != QProcess::NotRunning) {
+        send("quit");
+        if (!m_process.waitForFinished(3000))
+            m_process.kill();
+    }
+}
+
+bool SyntheticClient::start()
+{
+    QString executable = clientExecutable();
+    if (executable.isEmpty()) {
+        qWarning() << "SyntheticClient: Could not find the synthetic client executable";
+        return false;
+    }
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("QT_QPA_PLATFORM", "wayland");
+    environment.insert("WAYLAND_DISPLAY", m_socketName);
+    m_process.setProcessEnvironment(environment);
+    m_process.start(executable);
+    return m_process.waitForStarted();
+}
+
+qint64 SyntheticClient::processId() const
+{
+    return m_process.pid();
+}
+
+QString SyntheticClient::title(int window)
+{
+    return QString("synthetic-%1").arg(window);
+}
+
+void SyntheticClient::map(int window, const QSize &size, const QString &category)
+{
+    send(QString("map %1 %2 %3 %4").arg(window).arg(size.width()).arg(size.height()).arg(category));
+}
+
+void SyntheticClient::damage(int window, int rate)
+{
+    send(QString("damage %1 %2").arg(window).arg(rate));
+}
+
+void SyntheticClient::resize(int window, const QSize &size)
+{
+    send(QString("resize %1 %2 %3").arg(window).arg(size.width()).arg(size.height()));
+}
+
+void SyntheticClient::setWindowProperty(int window, const QString &name, const QString &value)
+{
+    send(QString("property %1 %2 %3").arg(window).arg(name).arg(value));
+}
+
+void SyntheticClient::unmap(int window)
+{
+    send(QString("unmap %1").arg(window));
+}
+
+void SyntheticClient::send(const QString &command)
+{
+    m_process.write(command.trimmed().toUtf8() + '\n');
+    m_process.waitForBytesWritten();
+}
@@ -0,0 +1,56 @@
+/***************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd.
+**
+** This file is part of lipstick.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef SYNTHETICCLIENT_H
+#define SYNTHETICCLIENT_H
+
+#include <QObject>
+#include <QProcess>
+#include <QSize>
+
+/*!
+ * Controls a synthetic Wayland client process, tests/syntheticclient. The
+ * client maps, damages, resizes and unmaps windows and sets their window
+ * properties as told. Windows are identified by a number given when they
+ * are mapped; their title is "synthetic-<number>". Commands are
+ * asynchronous; wait for their effect on the compositor side.
+ */
+class SyntheticClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SyntheticClient(const QString &socketName, QObject *parent = 0);
+    ~SyntheticClient();
+
+    bool start();
+    qint64 processId() const;
+
+    static QString title(int window);
+
+    void map(int window, const QSize &size, const QString &category = QString());
+    //! Repaints the whole window the given number of times a second, 0 stops
+    void damage(int window, int rate);
+    void resize(int window, const QSize &size);
+    void setWindowProperty(int window, const QString &name, const QString &value);
+    void unmap(int window);
+
+private:
+    void send(const QString &command);
+
+    QString m_socketName;
+    QProcess m_process;
+};
+
+#endif // SYNTHETICCLIENT_H
@@ -0,0 +1,195 @@
+/***************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd.
+**
+** This file is part of lipstick.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QWaylandSurface>
+#include "homeapplication.h"
+#include "lipstickcompositor.h"
+#include "lipstickcompositorwindow.h"
+#include "windowmodel.h"
+#include "compositortestharness.h"
+#include "syntheticclient.h"
+#include "ft_compositor.h"
+
+class TestWindowModel : public WindowModel
+{
+public:
+    void complete() { componentComplete(); }
+
+protected:
+    bool approveWindow(LipstickCompositorWindow *) { return true; }
+};
+
+void Ft_Compositor::initTestCase()
+{
+    harness = new CompositorTestHarness;
+    client = new SyntheticClient(CompositorTestHarness::socketName());
+    QVERIFY(client->start());
+}
+
+void Ft_Compositor::cleanupTestCase()
+{
+    delete client;
+    delete harness;
+}
+
+void Ft_Compositor::mapWindows(int count, int rate)
+{
+    for (int ii = 0; ii < count; ++ii) {
+        client->map(ii, QSize(480, 854));
+        if (rate > 0)
+            client->damage(ii, rate);
+    }
+}
+
+void Ft_Compositor::unmapWindows(int count)
+{
+    for (int ii = 0; ii < count; ++ii)
+        client->unmap(ii);
+}
+
+void Ft_Compositor::testMapAndUnmap()
+{
+    client->map(1, QSize(100, 200));
+    QVERIFY(harness->waitForWindowCount(1));
+
+    LipstickCompositorWindow *window = harness->windowForTitle(SyntheticClient::title(1));
+    QVERIFY(window != 0);
+    QCOMPARE(window->processId(), client->processId());
+
+    client->unmap(1);
+    QVERIFY(harness->waitForWindowCount(0));
+}
+
+void Ft_Compositor::testCategory()
+{
+    client->map(1, QSize(100, 200), "testcategory");
+    QVERIFY(harness->waitForWindowCount(1));
+
+    LipstickCompositorWindow *window = harness->windowForTitle(SyntheticClient::title(1));
+    QVERIFY(window != 0);
+    QCOMPARE(window->category(), QString("testcategory"));
+    QCOMPARE(harness->compositor()->windowIdsForCategory("testcategory"), QList<int>() << window->windowId());
+
+    client->unmap(1);
+    QVERIFY(harness->waitForWindowCount(0));
+}
+
+void Ft_Compositor::testResize()
+{
+    client->map(1, QSize(100, 200));
+    QVERIFY(harness->waitForWindowCount(1));
+    LipstickCompositorWindow *window = harness->windowForTitle(SyntheticClient::title(1));
+    QVERIFY(window != 0);
+
+    client->resize(1, QSize(300, 400));
+    QTRY_COMPARE(window->size(), QSizeF(300, 400));
+
+    client->unmap(1);
+    QVERIFY(harness->waitForWindowCount(0));
+}
+
+void Ft_Compositor::testWindowProperty()
+{
+    client->map(1, QSize(100, 200));
+    QVERIFY(harness->waitForWindowCount(1));
+    LipstickCompositorWindow *window = harness->windowForTitle(SyntheticClient::title(1));
+    QVERIFY(window != 0);
+
+    client->setWindowProperty(1, "NOTIFICATION_PREVIEWS_DISABLED", "2");
+    QTRY_COMPARE(window->notificationPreviewsDisabled(), 2u);
+
+    client->unmap(1);
+    QVERIFY(harness->waitForWindowCount(0));
+}
+
+void Ft_Compositor::benchmarkMapUnmap_data()
+{
+    QTest::addColumn<int>("windows");
+    QTest::newRow("1 window") << 1;
+    QTest::newRow("10 windows") << 10;
+    QTest::newRow("50 windows") << 50;
+}
+
+void Ft_Compositor::benchmarkMapUnmap()
+{
+    QFETCH(int, windows);
+
+    QElapsedTimer timer;
+    timer.start();
+    mapWindows(windows);
+    QVERIFY(harness->waitForWindowCount(windows, 30000));
+    unmapWindows(windows);
+    QVERIFY(harness->waitForWindowCount(0, 30000));
+
+    QTest::setBenchmarkResult(timer.elapsed(), QTest::WalltimeMilliseconds);
+}
+
+void Ft_Compositor::benchmarkWindowModelRefresh_data()
+{
+    benchmarkMapUnmap_data();
+}
+
+void Ft_Compositor::benchmarkWindowModelRefresh()
+{
+    QFETCH(int, windows);
+
+    mapWindows(windows);
+    QVERIFY(harness->waitForWindowCount(windows, 30000));
+
+    TestWindowModel model;
+    QBENCHMARK {
+        model.complete();
+    }
+    QCOMPARE(model.rowCount(), windows);
+
+    unmapWindows(windows);
+    QVERIFY(harness->waitForWindowCount(0, 30000));
+}
+
+void Ft_Compositor::benchmarkFrameTime_data()
+{
+    QTest::addColumn<int>("windows");
+    QTest::newRow("1 window") << 1;
+    QTest::newRow("5 windows") << 5;
+    QTest::newRow("20 windows") << 20;
+}
+
+void Ft_Compositor::benchmarkFrameTime()
+{
+    QFETCH(int, windows);
+
+    // Every window damages itself at 60 Hz; the benchmark is the time the
+    // render thread spends on a frame, without the wait for vsync
+    mapWindows(windows, 60);
+    QVERIFY(harness->waitForWindowCount(windows, 30000));
+    QVERIFY(harness->waitForFrames(10));
+
+    harness->resetFrameStatistics();
+    QTest::qWait(2000);
+    QVERIFY(harness->frameCount() > 1);
+    QTest::setBenchmarkResult(harness->averageRenderTime(), QTest::WalltimeMilliseconds);
+
+    unmapWindows(windows);
+    QVERIFY(harness->waitForWindowCount(0, 30000));
+}
+
+int main(int argc, char **argv)
+{
+    // The compositor needs the home application and its environment
+    CompositorTestHarness::initEnvironment();
+    HomeApplication app(argc, argv, QString());
+    Ft_Compositor test;
+    return QTest::qExec(&test, argc, argv);
+}
@@ -0,0 +1,51 @@
+/***************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd.
+**
+** This file is part of lipstick.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef FT_COMPOSITOR_H
+#define FT_COMPOSITOR_H
+
+#include <QObject>
+
+class CompositorTestHarness;
+class SyntheticClient;
+
+class Ft_Compositor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testMapAndUnmap();
+    void testCategory();
+    void testResize();
+    void testWindowProperty();
+
+    void benchmarkMapUnmap_data();
+    void benchmarkMapUnmap();
+    void benchmarkWindowModelRefresh_data();
+    void benchmarkWindowModelRefresh();
+    void benchmarkFrameTime_data();
+    void benchmarkFrameTime();
+
+private:
+    void mapWindows(int count, int rate = 0);
+    void unmapWindows(int count);
+
+    CompositorTestHarness *harness;
+    SyntheticClient *client;
+};
+
+#endif
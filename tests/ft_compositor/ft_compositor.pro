@@ -0,0 +1,7 @@
+include(../common.pri)
+include(../common/compositorharness.pri)
+TARGET = ft_compositor
+
+HEADERS += ft_compositor.h
+
+SOURCES += ft_compositor.cpp
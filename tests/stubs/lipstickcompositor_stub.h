@@ -33,10 +33,23 @@ class LipstickCompositorStub : public StubBase {
   virtual void setDisplayOff();
   virtual LipstickCompositorProcWindow * mapProcWindow(const QString &title, const QString &category, const QRect &);
   virtual QWaylandSurface * surfaceForId(int) const;
+  virtual uint windowNotificationPreviewsDisabled(int) const;
   virtual bool event(QEvent *);
   virtual void surfaceAboutToBeDestroyed(QWaylandSurface *surface);
   virtual void clearUpdateRequest();
   virtual void maybePostUpdateRequest();
+  virtual void startFrame();
+  virtual void sendFrameCallbacks();
+  virtual void frameSyncStarted();
+  virtual void frameRenderedOnRenderThread();
+  virtual void frameSwappedOnRenderThread();
+  virtual void prepareDisplayOn();
+  virtual void applySurfaceChanges();
+  virtual void grabFrameOnRenderThread();
+  virtual void flushTouchEvents();
+  virtual void sampleWindowStatistics();
+  virtual void releaseWindowBuffers();
+  virtual void reapBackgroundApplications();
   virtual void surfaceMapped();
   virtual void surfaceUnmapped();
   virtual void surfaceSizeChanged();
@@ -46,7 +59,7 @@ class LipstickCompositorStub : public StubBase {
   virtual void surfaceDamaged(const QRect &);
   virtual void windowSwapped();
   virtual void windowDestroyed();
-  virtual void windowPropertyChanged(const QString &);
+  virtual void windowPropertyChanged(const QString &, const QVariant &);
   virtual void reactOnDisplayStateChanges(MeeGo::QmDisplayState::DisplayState);
   virtual void setScreenOrientationFromSensor();
   virtual void clipboardDataChanged();
@@ -183,6 +196,13 @@ QWaylandSurface * LipstickCompositorStub::surfaceForId(int id) const {
   return stubReturnValue<QWaylandSurface *>("surfaceForId");
 }
 
+uint LipstickCompositorStub::windowNotificationPreviewsDisabled(int id) const {
+  QList<ParameterBase*> params;
+  params.append( new Parameter<int >(id));
+  stubMethodEntered("windowNotificationPreviewsDisabled",params);
+  return stubReturnValue<uint>("windowNotificationPreviewsDisabled");
+}
+
 bool LipstickCompositorStub::event(QEvent *e) {
   QList<ParameterBase*> params;
   params.append( new Parameter<QEvent * >(e));
@@ -204,6 +224,54 @@ void LipstickCompositorStub::maybePostUpdateRequest() {
   stubMethodEntered("maybePostUpdateRequest");
 }
 
+void LipstickCompositorStub::startFrame() {
+  stubMethodEntered("startFrame");
+}
+
+void LipstickCompositorStub::sendFrameCallbacks() {
+  stubMethodEntered("sendFrameCallbacks");
+}
+
+void LipstickCompositorStub::frameSyncStarted() {
+  stubMethodEntered("frameSyncStarted");
+}
+
+void LipstickCompositorStub::frameRenderedOnRenderThread() {
+  stubMethodEntered("frameRenderedOnRenderThread");
+}
+
+void LipstickCompositorStub::frameSwappedOnRenderThread() {
+  stubMethodEntered("frameSwappedOnRenderThread");
+}
+
+void LipstickCompositorStub::prepareDisplayOn() {
+  stubMethodEntered("prepareDisplayOn");
+}
+
+void LipstickCompositorStub::applySurfaceChanges() {
+  stubMethodEntered("applySurfaceChanges");
+}
+
+void LipstickCompositorStub::grabFrameOnRenderThread() {
+  stubMethodEntered("grabFrameOnRenderThread");
+}
+
+void LipstickCompositorStub::flushTouchEvents() {
+  stubMethodEntered("flushTouchEvents");
+}
+
+void LipstickCompositorStub::sampleWindowStatistics() {
+  stubMethodEntered("sampleWindowStatistics");
+}
+
+void LipstickCompositorStub::releaseWindowBuffers() {
+  stubMethodEntered("releaseWindowBuffers");
+}
+
+void LipstickCompositorStub::reapBackgroundApplications() {
+  stubMethodEntered("reapBackgroundApplications");
+}
+
 void LipstickCompositorStub::surfaceMapped() {
   stubMethodEntered("surfaceMapped");
 }
@@ -242,9 +310,10 @@ void LipstickCompositorStub::windowDestroyed() {
   stubMethodEntered("windowDestroyed");
 }
 
-void LipstickCompositorStub::windowPropertyChanged(const QString &property) {
+void LipstickCompositorStub::windowPropertyChanged(const QString &property, const QVariant &value) {
   QList<ParameterBase*> params;
   params.append( new Parameter<const QString & >(property));
+  params.append( new Parameter<const QVariant & >(value));
   stubMethodEntered("windowPropertyChanged",params);
 }
 
@@ -365,6 +434,10 @@ QWaylandSurface * LipstickCompositor::surfaceForId(int id) const {
   return gLipstickCompositorStub->surfaceForId(id);
 }
 
+uint LipstickCompositor::windowNotificationPreviewsDisabled(int id) const {
+  return gLipstickCompositorStub->windowNotificationPreviewsDisabled(id);
+}
+
 bool LipstickCompositor::event(QEvent *e) {
     return gLipstickCompositorStub->event(e);
 }
@@ -381,6 +454,54 @@ void LipstickCompositor::maybePostUpdateRequest() {
     gLipstickCompositorStub->maybePostUpdateRequest();
 }
 
+void LipstickCompositor::startFrame() {
+    gLipstickCompositorStub->startFrame();
+}
+
+void LipstickCompositor::sendFrameCallbacks() {
+    gLipstickCompositorStub->sendFrameCallbacks();
+}
+
+void LipstickCompositor::frameSyncStarted() {
+    gLipstickCompositorStub->frameSyncStarted();
+}
+
+void LipstickCompositor::frameRenderedOnRenderThread() {
+    gLipstickCompositorStub->frameRenderedOnRenderThread();
+}
+
+void LipstickCompositor::frameSwappedOnRenderThread() {
+    gLipstickCompositorStub->frameSwappedOnRenderThread();
+}
+
+void LipstickCompositor::prepareDisplayOn() {
+    gLipstickCompositorStub->prepareDisplayOn();
+}
+
+void LipstickCompositor::applySurfaceChanges() {
+    gLipstickCompositorStub->applySurfaceChanges();
+}
+
+void LipstickCompositor::grabFrameOnRenderThread() {
+    gLipstickCompositorStub->grabFrameOnRenderThread();
+}
+
+void LipstickCompositor::flushTouchEvents() {
+    gLipstickCompositorStub->flushTouchEvents();
+}
+
+void LipstickCompositor::sampleWindowStatistics() {
+    gLipstickCompositorStub->sampleWindowStatistics();
+}
+
+void LipstickCompositor::releaseWindowBuffers() {
+    gLipstickCompositorStub->releaseWindowBuffers();
+}
+
+void LipstickCompositor::reapBackgroundApplications() {
+    gLipstickCompositorStub->reapBackgroundApplications();
+}
+
 void LipstickCompositor::surfaceMapped() {
   gLipstickCompositorStub->surfaceMapped();
 }
@@ -417,8 +538,8 @@ void LipstickCompositor::windowDestroyed() {
   gLipstickCompositorStub->windowDestroyed();
 }
 
-void LipstickCompositor::windowPropertyChanged(const QString &property) {
-  gLipstickCompositorStub->windowPropertyChanged(property);
+void LipstickCompositor::windowPropertyChanged(const QString &property, const QVariant &value) {
+  gLipstickCompositorStub->windowPropertyChanged(property, value);
 }
 
 void LipstickCompositor::reactOnDisplayStateChanges(MeeGo::QmDisplayState::DisplayState state) {
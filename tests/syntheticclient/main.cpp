@@ -0,0 +1,169 @@
+/***************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd.
+**
+** This file is part of lipstick.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+// Synthetic Wayland client for the compositor tests, driven by commands on
+// standard input, one per line:
+//   map <window> <width> <height> [category]
+//   damage <window> <rate>
+//   resize <window> <width> <height>
+//   property <window> <name> <value>
+//   unmap <window>
+//   quit
+
+#include <QGuiApplication>
+#include <QWindow>
+#include <QBackingStore>
+#include <QPainter>
+#include <QTimer>
+#include <QSocketNotifier>
+#include <QHash>
+#include <QStringList>
+#include <QDebug>
+#include <qpa/qplatformnativeinterface.h>
+#include <unistd.h>
+
+class SyntheticWindow : public QWindow
+{
+    Q_OBJECT
+
+public:
+    SyntheticWindow(int id, const QSize &size) : m_backingStore(this), m_frame(0)
+    {
+        setTitle(QString("synthetic-%1").arg(id));
+        resize(size);
+        connect(&m_damageTimer, SIGNAL(timeout()), this, SLOT(render()));
+    }
+
+    void setDamageRate(int rate)
+    {
+        if (rate > 0)
+            m_damageTimer.start(1000 / rate);
+        else
+            m_damageTimer.stop();
+    }
+
+protected:
+    void exposeEvent(QExposeEvent *)
+    {
+        if (isExposed())
+            render();
+    }
+
+    void resizeEvent(QResizeEvent *)
+    {
+        m_backingStore.resize(size());
+        if (isExposed())
+            render();
+    }
+
+private slots:
+    void render()
+    {
+        QRect rect(QPoint(), size());
+        m_backingStore.beginPaint(rect);
+        QPainter painter(m_backingStore.paintDevice());
+        painter.fillRect(rect, (m_frame++ & 1) ? Qt::darkGray : Qt::lightGray);
+        painter.end();
+        m_backingStore.endPaint();
+        m_backingStore.flush(rect);
+    }
+
+private:
+    QBackingStore m_backingStore;
+    QTimer m_damageTimer;
+    int m_frame;
+};
+
+class CommandReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    CommandReader() : m_notifier(STDIN_FILENO, QSocketNotifier::Read)
+    {
+        connect(&m_notifier, SIGNAL(activated(int)), this, SLOT(readCommands()));
+    }
+
+private slots:
+    void readCommands()
+    {
+        // Several commands may arrive in one read, or one command across reads
+        char data[4096];
+        ssize_t length = read(STDIN_FILENO, data, sizeof(data));
+        if (length <= 0) {
+            m_notifier.setEnabled(false);
+            qApp->quit();
+            return;
+        }
+        m_input.append(data, length);
+
+        int end;
+        while ((end = m_input.indexOf('\n')) >= 0) {
+            QByteArray line = m_input.left(end);
+            m_input.remove(0, end + 1);
+            runCommand(QString::fromUtf8(line));
+        }
+    }
+
+private:
+    void runCommand(const QString &line)
+    {
+        QStringList args = line.trimmed().split(' ', QString::SkipEmptyParts);
+        if (args.isEmpty())
+            return;
+
+        QString command = args.takeFirst();
+        int id = args.isEmpty() ? 0 : args.first().toInt();
+        SyntheticWindow *window = m_windows.value(id);
+
+        if (command == "quit") {
+            qApp->quit();
+        } else if (command == "map" && args.count() >= 3 && !window) {
+            window = new SyntheticWindow(id, QSize(args.at(1).toInt(), args.at(2).toInt()));
+            window->create();
+            if (args.count() > 3)
+                setWindowProperty(window, "CATEGORY", args.at(3));
+            window->show();
+            m_windows.insert(id, window);
+        } else if (command == "damage" && args.count() == 2 && window) {
+            window->setDamageRate(args.at(1).toInt());
+        } else if (command == "resize" && args.count() == 3 && window) {
+            window->resize(args.at(1).toInt(), args.at(2).toInt());
+        } else if (command == "property" && args.count() >= 3 && window) {
+            setWindowProperty(window, args.at(1), QStringList(args.mid(2)).join(" "));
+        } else if (command == "unmap" && window) {
+            delete m_windows.take(id);
+        } else {
+            qWarning() << "syntheticclient: Invalid command" << line;
+        }
+    }
+
+    void setWindowProperty(QWindow *window, const QString &name, const QVariant &value)
+    {
+        QGuiApplication::platformNativeInterface()->setWindowProperty(window->handle(), name, value);
+    }
+
+    QSocketNotifier m_notifier;
+    QByteArray m_input;
+    QHash<int, SyntheticWindow *> m_windows;
+};
+
+int main(int argc, char **argv)
+{
+    QGuiApplication app(argc, argv);
+    CommandReader reader;
+    return app.exec();
+}
+
+#include "main.moc"
@@ -0,0 +1,8 @@
+TARGET = syntheticclient
+TEMPLATE = app
+QT += gui gui-private
+
+SOURCES += main.cpp
+
+target.path = /opt/tests/lipstick-tests
+INSTALLS += target
@@ -1,10 +1,13 @@
 TEMPLATE = subdirs
 SUBDIRS = \
+          syntheticclient \
+          ft_compositor \
           ut_batterynotifier \
           ut_categorydefinitionstore \
           ut_closeeventeater \
           ut_devicelock \
           ut_diskspacenotifier \
+          ut_inputrouter \
           ut_lipsticksettings \
           ut_lowbatterynotifier \
           ut_lipsticknotification \
@@ -17,6 +20,8 @@ SUBDIRS = \
           ut_usbmodeselector \
           ut_volumecontrol \
 
+ft_compositor.depends = syntheticclient
+
 support_files.commands += $$PWD/gen-tests-xml.sh > $$OUT_PWD/tests.xml
 support_files.target = support_files
 support_files.files += $$OUT_PWD/tests.xml
@@ -0,0 +1,125 @@
+/***************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd.
+**
+** This file is part of lipstick.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include "ut_inputrouter.h"
+#include "inputrouter.h"
+
+class TestKeyHandler : public InputRouter::KeyHandler
+{
+public:
+    TestKeyHandler() : lastKey(0) {}
+
+    bool handleKeyEvent(QKeyEvent *event)
+    {
+        lastKey = event->key();
+        return true;
+    }
+
+    int lastKey;
+};
+
+QList<QObject *> qObjectInstalledEventFilters;
+void QObject::installEventFilter(QObject *filterObj)
+{
+    qObjectInstalledEventFilters.append(filterObj);
+}
+
+void QObject::removeEventFilter(QObject *obj)
+{
+    qObjectInstalledEventFilters.removeAll(obj);
+}
+
+void Ut_InputRouter::cleanup()
+{
+    InputRouter *router = InputRouter::instance();
+    router->keyHandlers.clear();
+    router->grabbedKeys.clear();
+    router->setVolumeKeyHandler(0);
+    router->setEatingEvents(false);
+}
+
+void Ut_InputRouter::testGrabbedKeysAreRoutedToTheLatestOwner()
+{
+    TestKeyHandler first;
+    TestKeyHandler second;
+    QKeyEvent event(QEvent::KeyPress, Qt::Key_Camera, 0);
+
+    InputRouter::instance()->setGrabbedKeys(&first, QList<int>() << Qt::Key_Camera);
+    InputRouter::instance()->setGrabbedKeys(&second, QList<int>() << Qt::Key_Camera);
+    QCOMPARE(InputRouter::instance()->eventFilter(0, &event), true);
+    QCOMPARE(first.lastKey, 0);
+    QCOMPARE(second.lastKey, (int)Qt::Key_Camera);
+
+    // Releasing the grab gives the key back to the earlier owner
+    InputRouter::instance()->setGrabbedKeys(&second, QList<int>());
+    QCOMPARE(InputRouter::instance()->eventFilter(0, &event), true);
+    QCOMPARE(first.lastKey, (int)Qt::Key_Camera);
+
+    InputRouter::instance()->setGrabbedKeys(&first, QList<int>());
+    QCOMPARE(InputRouter::instance()->eventFilter(0, &event), false);
+}
+
+void Ut_InputRouter::testVolumeKeysFallBackToTheVolumeKeyHandler()
+{
+    TestKeyHandler volume;
+    TestKeyHandler grabber;
+    QKeyEvent up(QEvent::KeyPress, Qt::Key_VolumeUp, 0);
+    QKeyEvent other(QEvent::KeyPress, Qt::Key_Camera, 0);
+
+    InputRouter::instance()->setVolumeKeyHandler(&volume);
+    QCOMPARE(InputRouter::instance()->eventFilter(0, &other), false);
+    QCOMPARE(InputRouter::instance()->eventFilter(0, &up), true);
+    QCOMPARE(volume.lastKey, (int)Qt::Key_VolumeUp);
+
+    // A window grabbing the volume keys takes precedence
+    volume.lastKey = 0;
+    InputRouter::instance()->setGrabbedKeys(&grabber, QList<int>() << Qt::Key_VolumeUp);
+    QCOMPARE(InputRouter::instance()->eventFilter(0, &up), true);
+    QCOMPARE(volume.lastKey, 0);
+    QCOMPARE(grabber.lastKey, (int)Qt::Key_VolumeUp);
+}
+
+void Ut_InputRouter::testEventEater()
+{
+    QSignalSpy spy(InputRouter::instance(), SIGNAL(eventEaten()));
+    QMouseEvent event(QEvent::MouseButtonPress, QPointF(), Qt::NoButton, 0, 0);
+
+    QCOMPARE(InputRouter::instance()->eventFilter(0, &event), false);
+    QCOMPARE(spy.count(), 0);
+
+    InputRouter::instance()->setEatingEvents(true);
+    QCOMPARE(InputRouter::instance()->eventFilter(0, &event), true);
+    QCOMPARE(spy.count(), 1);
+}
+
+void Ut_InputRouter::testEventFilterIsOnlyInstalledWhenNeeded()
+{
+    TestKeyHandler handler;
+    QVERIFY(!qObjectInstalledEventFilters.contains(InputRouter::instance()));
+
+    InputRouter::instance()->setGrabbedKeys(&handler, QList<int>() << Qt::Key_Camera);
+    QCOMPARE(qObjectInstalledEventFilters.count(InputRouter::instance()), 1);
+
+    InputRouter::instance()->setEatingEvents(true);
+    QCOMPARE(qObjectInstalledEventFilters.count(InputRouter::instance()), 1);
+
+    InputRouter::instance()->setGrabbedKeys(&handler, QList<int>());
+    InputRouter::instance()->setEatingEvents(false);
+    QVERIFY(!qObjectInstalledEventFilters.contains(InputRouter::instance()));
+}
+
+QTEST_MAIN(Ut_InputRouter)
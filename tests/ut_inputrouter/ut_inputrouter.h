@@ -0,0 +1,35 @@
+/***************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd.
+**
+** This file is part of lipstick.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef UT_INPUTROUTER_H
+#define UT_INPUTROUTER_H
+
+#include <QObject>
+
+class Ut_InputRouter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Called after every testfunction
+    void cleanup();
+
+    // Test cases
+    void testGrabbedKeysAreRoutedToTheLatestOwner();
+    void testVolumeKeysFallBackToTheVolumeKeyHandler();
+    void testEventEater();
+    void testEventFilterIsOnlyInstalledWhenNeeded();
+};
+
+#endif
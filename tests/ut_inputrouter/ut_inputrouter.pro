@@ -0,0 +1,14 @@
+include(../common.pri)
+TARGET = ut_inputrouter
+
+INCLUDEPATH += $$UTILITYSRCDIR
+
+# unit test and unit
+SOURCES += \
+    ut_inputrouter.cpp \
+    $$UTILITYSRCDIR/inputrouter.cpp
+
+# unit test and unit
+HEADERS += \
+    ut_inputrouter.h \
+    $$UTILITYSRCDIR/inputrouter.h
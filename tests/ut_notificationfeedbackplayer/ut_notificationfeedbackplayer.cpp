@@ -98,12 +98,6 @@ LipstickNotification *createNotification(uint id, int urgency = 0)
     return notification;
 }
 
-QVariantMap qWaylandSurfaceWindowProperties;
-QVariantMap QWaylandSurface::windowProperties() const
-{
-    return qWaylandSurfaceWindowProperties;
-}
-
 void QTimer::singleShot(int, const QObject *receiver, const char *member)
 {
     // The "member" string is of form "1member()", so remove the trailing 1 and the ()
@@ -201,45 +195,29 @@ void Ut_NotificationFeedbackPlayer::testUpdateNotificationIsNotPossibleAfterRest
     QCOMPARE(gClientStub->stubCallCount("play"), 0);
 }
 
-QWaylandSurface surface;
 void Ut_NotificationFeedbackPlayer::testNotificationPreviewsDisabled_data()
 {
-    QTest::addColumn<QWaylandSurface *>("surface");
-    QTest::addColumn<QVariantMap>("windowProperties");
+    QTest::addColumn<uint>("notificationPreviewsDisabled");
     QTest::addColumn<int>("urgency");
     QTest::addColumn<int>("playCount");
 
-    QVariantMap allNotificationsEnabled;
-    QVariantMap applicationNotificationsDisabled;
-    QVariantMap systemNotificationsDisabled;
-    QVariantMap allNotificationsDisabled;
-    allNotificationsEnabled.insert("NOTIFICATION_PREVIEWS_DISABLED", 0);
-    applicationNotificationsDisabled.insert("NOTIFICATION_PREVIEWS_DISABLED", 1);
-    systemNotificationsDisabled.insert("NOTIFICATION_PREVIEWS_DISABLED", 2);
-    allNotificationsDisabled.insert("NOTIFICATION_PREVIEWS_DISABLED", 3);
-    QTest::newRow("No surface, application notification") << (QWaylandSurface *)0 << QVariantMap() << 1 << 1;
-    QTest::newRow("Surface, no properties, application notification") << &surface << QVariantMap() << 1 << 1;
-    QTest::newRow("Surface, all notifications enabled, application notification") << &surface << allNotificationsEnabled << 1 << 1;
-    QTest::newRow("Surface, application notifications disabled, application notification") << &surface << applicationNotificationsDisabled << 1 << 0;
-    QTest::newRow("Surface, system notifications disabled, application notification") << &surface << systemNotificationsDisabled << 1 << 1;
-    QTest::newRow("Surface, all notifications disabled, application notification") << &surface << allNotificationsDisabled << 1 << 0;
-    QTest::newRow("No surface, system notification") << (QWaylandSurface *)0 << QVariantMap() << 2 << 1;
-    QTest::newRow("Surface, no properties, system notification") << &surface << QVariantMap() << 2 << 1;
-    QTest::newRow("Surface, all notifications enabled, system notification") << &surface << allNotificationsEnabled << 2 << 1;
-    QTest::newRow("Surface, application notifications disabled, system notification") << &surface << applicationNotificationsDisabled << 2 << 1;
-    QTest::newRow("Surface, system notifications disabled, system notification") << &surface << systemNotificationsDisabled << 2 << 0;
-    QTest::newRow("Surface, all notifications disabled, system notification") << &surface << allNotificationsDisabled << 2 << 0;
+    QTest::newRow("No window or no property, application notification") << 0u << 1 << 1;
+    QTest::newRow("Application notifications disabled, application notification") << 1u << 1 << 0;
+    QTest::newRow("System notifications disabled, application notification") << 2u << 1 << 1;
+    QTest::newRow("All notifications disabled, application notification") << 3u << 1 << 0;
+    QTest::newRow("No window or no property, system notification") << 0u << 2 << 1;
+    QTest::newRow("Application notifications disabled, system notification") << 1u << 2 << 1;
+    QTest::newRow("System notifications disabled, system notification") << 2u << 2 << 0;
+    QTest::newRow("All notifications disabled, system notification") << 3u << 2 << 0;
 }
 
 void Ut_NotificationFeedbackPlayer::testNotificationPreviewsDisabled()
 {
-    QFETCH(QWaylandSurface *, surface);
-    QFETCH(QVariantMap, windowProperties);
+    QFETCH(uint, notificationPreviewsDisabled);
     QFETCH(int, urgency);
     QFETCH(int, playCount);
 
-    gLipstickCompositorStub->stubSetReturnValue("surfaceForId", surface);
-    qWaylandSurfaceWindowProperties = windowProperties;
+    gLipstickCompositorStub->stubSetReturnValue("windowNotificationPreviewsDisabled", notificationPreviewsDisabled);
 
     createNotification(1, urgency);
     player->addNotification(1);
@@ -25,6 +25,7 @@
 
 #include "ut_screenlock.h"
 #include "screenlock.h"
+#include "inputrouter.h"
 #include "homeapplication.h"
 #include "closeeventeater_stub.h"
 
@@ -106,10 +107,10 @@ void Ut_ScreenLock::testToggleEventEater()
 
     // Make sure the screen locking signals are sent and the eater UI is shown/hidden
     screenLock->toggleEventEater(true);
-    QCOMPARE(screenLock->eventFilter(0, &event), true);
+    QCOMPARE(InputRouter::instance()->eventFilter(0, &event), true);
 
     screenLock->toggleEventEater(false);
-    QCOMPARE(screenLock->eventFilter(0, &event), false);
+    QCOMPARE(InputRouter::instance()->eventFilter(0, &event), false);
 }
 
 void Ut_ScreenLock::testUnlockScreenWhenLocked()
@@ -179,7 +180,7 @@ void Ut_ScreenLock::testTkLockOpen()
 
     if (eventEaterWindowVisibilityModified) {
         QMouseEvent event(QEvent::MouseButtonPress, QPointF(), Qt::NoButton, 0, 0);
-        QCOMPARE(screenLock->eventFilter(0, &event), eventEaterWindowVisible);
+        QCOMPARE(InputRouter::instance()->eventFilter(0, &event), eventEaterWindowVisible);
     }
 }
 
@@ -200,7 +201,7 @@ void Ut_ScreenLock::testTkLockClose()
 
     // Events should still be eaten
     QMouseEvent event(QEvent::MouseButtonPress, QPointF(), Qt::NoButton, 0, 0);
-    QCOMPARE(screenLock->eventFilter(0, &event), true);
+    QCOMPARE(InputRouter::instance()->eventFilter(0, &event), true);
 }
 
 QTEST_MAIN(Ut_ScreenLock)
@@ -7,8 +7,10 @@ INCLUDEPATH += $$SCREENLOCKSRCDIR $$UTILITYSRCDIR $$SRCDIR/xtools
 
 SOURCES += ut_screenlock.cpp \
     $$SCREENLOCKSRCDIR/screenlock.cpp \
+    $$UTILITYSRCDIR/inputrouter.cpp \
     $$STUBSDIR/stubbase.cpp
 
 HEADERS += ut_screenlock.h \
     $$SCREENLOCKSRCDIR/screenlock.h \
-    $$UTILITYSRCDIR/closeeventeater.h
+    $$UTILITYSRCDIR/closeeventeater.h \
+    $$UTILITYSRCDIR/inputrouter.h
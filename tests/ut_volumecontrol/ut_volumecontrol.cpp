@@ -18,9 +18,11 @@
 #include <QDBusConnection>
 #include "ut_volumecontrol.h"
 #include "volumecontrol.h"
+#include "inputrouter.h"
 #include "pulseaudiocontrol_stub.h"
 #include "closeeventeater_stub.h"
 #include "mgconfitem_stub.h"
+#include "qmdisplaystate_stub.h"
 
 extern "C"
 {
@@ -115,6 +117,8 @@ void Ut_VolumeControl::cleanupTestCase()
 void Ut_VolumeControl::init()
 {
     gPulseAudioControlStub->stubReset();
+    gQmDisplayStateStub->stubReset();
+    gQmDisplayStateStub->stubSetReturnValue("get", MeeGo::QmDisplayState::On);
 
     volumeControl = new VolumeControl;
     volumeControl->setVolume(5, 10);
@@ -182,7 +186,7 @@ void Ut_VolumeControl::testEventFilter()
 
     QSignalSpy spy(volumeControl, SIGNAL(volumeChanged()));
     QKeyEvent event(type, key, 0);
-    volumeControl->eventFilter(0, &event);
+    InputRouter::instance()->eventFilter(0, &event);
 
     QCOMPARE(spy.count(), signalCount);
     if(signalCount > 0) {
@@ -198,14 +202,14 @@ void Ut_VolumeControl::testHwKeyEventWhenKeyRepeatDelayIsInProgress()
     QSignalSpy spy(volumeControl, SIGNAL(volumeChanged()));
 
     QKeyEvent upEvent(QEvent::KeyPress, Qt::Key_VolumeUp, 0);
-    volumeControl->eventFilter(0, &upEvent);
+    InputRouter::instance()->eventFilter(0, &upEvent);
     QCOMPARE(qTimerStartCounts.value(&volumeControl->keyRepeatDelayTimer), 1);
     QCOMPARE(qTimerStartCounts.value(&volumeControl->keyRepeatTimer), 0);
     QCOMPARE(spy.count(), 1);
 
     // Only the first press should cause the timer to be started and the volume change request to be made
     QKeyEvent downEvent(QEvent::KeyPress, Qt::Key_VolumeUp, 0);
-    volumeControl->eventFilter(0, &downEvent);
+    InputRouter::instance()->eventFilter(0, &downEvent);
     QCOMPARE(qTimerStartCounts.value(&volumeControl->keyRepeatDelayTimer), 1);
     QCOMPARE(qTimerStartCounts.value(&volumeControl->keyRepeatTimer), 0);
     QCOMPARE(spy.count(), 1);
@@ -231,7 +235,7 @@ void Ut_VolumeControl::testHwKeyEventWhenKeyRepeatIsInProgress()
 
     // Further presses should not cause the timer to be started and the volume change request to be made
     QKeyEvent event(QEvent::KeyPress, Qt::Key_VolumeDown, 0);
-    volumeControl->eventFilter(0, &event);
+    InputRouter::instance()->eventFilter(0, &event);
     QCOMPARE(qTimerStartCounts.value(&volumeControl->keyRepeatDelayTimer), 0);
     QCOMPARE(qTimerStartCounts.value(&volumeControl->keyRepeatTimer), 1);
     QCOMPARE(spy.count(), 0);
@@ -252,7 +256,7 @@ void Ut_VolumeControl::testHwKeyEventWhenKeyReleaseIsInProgress()
 
     // Key release should not stop the repeat timer but start the release timer
     QKeyEvent event(QEvent::KeyRelease, Qt::Key_VolumeDown, 0);
-    volumeControl->eventFilter(0, &event);
+    InputRouter::instance()->eventFilter(0, &event);
     QCOMPARE(qTimerStartCounts.value(&volumeControl->keyReleaseTimer), 1);
     QCOMPARE(qTimerStartCounts.value(&volumeControl->keyRepeatDelayTimer), 0);
     QCOMPARE(qTimerStartCounts.value(&volumeControl->keyRepeatTimer), 1);
@@ -266,6 +270,28 @@ void Ut_VolumeControl::testHwKeyEventWhenKeyReleaseIsInProgress()
     QCOMPARE(qTimerStopCounts.value(&volumeControl->keyRepeatTimer), 1);
 }
 
+void Ut_VolumeControl::testVolumeKeyHandlerFollowsDisplayState()
+{
+    volumeControl->hwKeyResourceAcquired();
+    QCOMPARE(InputRouter::instance()->volumeKeyHandler(), static_cast<InputRouter::KeyHandler *>(volumeControl));
+
+    gQmDisplayStateStub->stubSetReturnValue("get", MeeGo::QmDisplayState::Off);
+    volumeControl->updateVolumeKeyHandler();
+    QCOMPARE(InputRouter::instance()->volumeKeyHandler(), static_cast<InputRouter::KeyHandler *>(0));
+
+    QSignalSpy spy(volumeControl, SIGNAL(volumeChanged()));
+    QKeyEvent event(QEvent::KeyPress, Qt::Key_VolumeUp, 0);
+    InputRouter::instance()->eventFilter(0, &event);
+    QCOMPARE(spy.count(), 0);
+
+    gQmDisplayStateStub->stubSetReturnValue("get", MeeGo::QmDisplayState::On);
+    volumeControl->updateVolumeKeyHandler();
+    QCOMPARE(InputRouter::instance()->volumeKeyHandler(), static_cast<InputRouter::KeyHandler *>(volumeControl));
+
+    volumeControl->hwKeyResourceLost();
+    QCOMPARE(InputRouter::instance()->volumeKeyHandler(), static_cast<InputRouter::KeyHandler *>(0));
+}
+
 void Ut_VolumeControl::testAcquireKeys()
 {
     volumeControl->acquireKeys();
@@ -39,6 +39,7 @@ private slots:
     void testHwKeyEventWhenKeyRepeatDelayIsInProgress();
     void testHwKeyEventWhenKeyRepeatIsInProgress();
     void testHwKeyEventWhenKeyReleaseIsInProgress();
+    void testVolumeKeyHandlerFollowsDisplayState();
     void testAcquireKeys();
     void testReleaseKeys();
 
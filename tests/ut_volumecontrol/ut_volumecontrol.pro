@@ -11,11 +11,14 @@ HEADERS += \
     $$VOLUMESRCDIR/volumecontrol.h \
     $$VOLUMESRCDIR/pulseaudiocontrol.h \
     $$UTILITYSRCDIR/closeeventeater.h \
+    $$UTILITYSRCDIR/inputrouter.h \
     $$SRCDIR/homewindow.h \
     /usr/include/mlite5/mgconfitem.h \
+    /usr/include/qmsystem2-qt5/qmdisplaystate.h \
 
 SOURCES += \
     ut_volumecontrol.cpp \
     $$VOLUMESRCDIR/volumecontrol.cpp \
+    $$UTILITYSRCDIR/inputrouter.cpp \
     $$STUBSDIR/stubbase.cpp \
     $$STUBSDIR/homewindow.cpp \